@@ -0,0 +1,59 @@
+/* created by Ghabriel Nunes <ghabriel.nunes@gmail.com> [2016] */
+
+#ifndef BYTECLASSES_HPP
+#define BYTECLASSES_HPP
+
+#include <array>
+#include <bitset>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * A partition of the 256 byte values in which bytes that behave identically
+ * in every state of an automaton share a class id. It starts with a single
+ * class and is refined once per state; class ids are always in the range
+ * [0, size), so they can be used directly as table columns.
+ */
+class ByteClasses {
+public:
+    using ClassMap = std::array<unsigned char, 256>;
+
+    ByteClasses();
+
+    // Splits the classes according to the transitions of a state, so that
+    // bytes leading to different targets end up in different classes.
+    // Bytes without a transition are considered to share a target.
+    // Complexity: O(t.log t), where t is the number of transitions
+    void refine(const std::unordered_map<char, long>&);
+
+    // Splits the classes so that the bytes of a set are kept apart
+    // from the remaining ones.
+    // Complexity: O(256)
+    void split(const std::bitset<256>&);
+
+    // Returns the number of classes.
+    std::size_t size() const;
+
+    // Returns the class of a byte.
+    unsigned char operator[](char c) const {
+        return classes[static_cast<unsigned char>(c)];
+    }
+
+    // Returns the byte-to-class map.
+    const ClassMap& map() const;
+
+    // Returns one byte of each class, indexed by class id.
+    std::vector<char> representatives() const;
+
+private:
+    using Entry = std::tuple<unsigned, long, unsigned char>;
+    ClassMap classes;
+    std::vector<unsigned> population;
+
+    // Splits the classes according to a list of (class, target, byte)
+    // entries, which is sorted in the process.
+    void refine(std::vector<Entry>&);
+};
+
+#endif
@@ -8,6 +8,7 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
+#include "IndexList.hpp"
 #include "representations/CFGRepresentation.hpp"
 
 class CFG;
@@ -16,6 +17,7 @@ class Production {
     friend class CFG;
 public:
     using Symbol = std::string;
+    using SymbolId = std::size_t;
     explicit Production(const std::string& name) : name(name) {}
     std::string getName() const {
         return name;
@@ -25,7 +27,18 @@ public:
         return products;
     }
 
-    const std::unordered_set<Symbol>& getFirstSet() const {
+    // Returns the id of the name of this production (see CFG::id).
+    SymbolId getNameId() const {
+        return nameId;
+    }
+
+    // Returns the ids of the symbols on the right-hand side.
+    const std::vector<SymbolId>& getProductIds() const {
+        return productIds;
+    }
+
+    // Returns the first set of this production, as a bitset of ids.
+    const IndexList& getFirstSet() const {
         return firstSet;
     }
 
@@ -47,8 +60,10 @@ public:
 private:
     std::string name;
     std::vector<Symbol> products;
-    mutable std::unordered_set<Symbol> firstSet;
-    mutable bool nullable;
+    SymbolId nameId;
+    std::vector<SymbolId> productIds;
+    mutable IndexList firstSet{0, false};
+    mutable bool nullable = false;
 };
 
 /*
@@ -59,9 +74,14 @@ private:
  *   'p': maximum number of symbols on the right-hand side of the productions;
  *   'L': number of symbols in the BNF string received as input.
  * Note that the result of several operations is cached to improve
- * performance. Some of these cached structures are invalidated when
- * a new production is added to the CFG, although it doesn't necessarily
- * happen.
+ * performance. Once calculated, nullability, first and follow sets are
+ * updated incrementally when a new production is added to the CFG,
+ * propagating only its contributions.
+ *
+ * Every symbol is interned when it's first added, receiving a dense id
+ * in the range [0, s), and all analyses work on these ids internally.
+ * Nullability, first and follow sets are calculated together over
+ * bitsets indexed by these ids.
  *
  * The Strategy Pattern is used to decouple the grammar representation
  * from the functionality provided by this class. A static factory method
@@ -70,7 +90,9 @@ private:
 class CFG {
 public:
     using Symbol = std::string;
+    using SymbolId = Production::SymbolId;
     using BNF = std::string;
+    const static SymbolId npos = -1;
 
     enum ReferenceType {
         NONE,
@@ -93,6 +115,17 @@ public:
     CFG& add(const BNF&);
     CFG& operator<<(const BNF&);
 
+    // Returns the id of a symbol, interning it with the given kind if it's
+    // not used in this CFG yet. Unlike the methods above, it doesn't
+    // depend on the representation, so it may create symbols that can't
+    // be written in it.
+    // Complexity: O(1)
+    SymbolId addSymbol(const Symbol&, bool terminal);
+
+    // Adds a production given the ids of its name and right-hand side.
+    // Complexity: O(p) if no analysis was done, otherwise see update()
+    CFG& addProduction(SymbolId, const std::vector<SymbolId>&);
+
     // Clears this CFG.
     void clear();
 
@@ -108,19 +141,65 @@ public:
     // Complexity: O(1)
     std::unordered_set<Symbol> getTerminals() const;
 
+    // Returns the number of symbols used in this CFG, which is also
+    // an upper bound for their ids.
+    // Complexity: O(1)
+    std::size_t numSymbols() const;
+
+    // Returns the id of a symbol, or npos if it's not used in this CFG.
+    // Complexity: O(1)
+    SymbolId id(const Symbol&) const;
+
+    // Returns the symbol of a given id.
+    // Complexity: O(1)
+    const Symbol& symbol(SymbolId) const;
+
+    // Checks if the symbol of a given id is a terminal.
+    // Complexity: O(1)
+    bool isTerminal(SymbolId) const;
+
+    // Returns the indexes of the productions of a non-terminal.
+    // Complexity: O(1)
+    const std::vector<std::size_t>& productionsOf(SymbolId) const;
+
+    // Returns the first set of a symbol as a bitset of ids. The first
+    // set of a terminal contains only itself.
+    // Complexity: O(nps) on first call, O(1) on subsequent calls
+    const IndexList& firstOf(SymbolId) const;
+
+    // Returns the follow set of a symbol as a bitset of ids. It has
+    // an extra position, endOfInput(), which is set if the symbol
+    // is endable.
+    // Complexity: O(nps) on first call, O(1) on subsequent calls
+    const IndexList& followOf(SymbolId) const;
+
+    // Returns the position that represents the end of the input in
+    // follow sets. It's greater than or equal to numSymbols(), and may
+    // change when productions are added.
+    // Complexity: O(nps) on first call, O(1) on subsequent calls
+    SymbolId endOfInput() const;
+
+    // Checks if a symbol is nullable.
+    // Complexity: O(nps) on first call, O(1) on subsequent calls
+    bool nullable(SymbolId) const;
+
+    // Checks if a non-terminal is endable.
+    // Complexity: O(nps) on first call, O(1) on subsequent calls
+    bool endable(SymbolId) const;
+
     // Checks if there are any undefined non-terminals
     // being used in this CFG.
     // Complexity: O(s)
     bool isConsistent() const;
 
     // Prepares the first set of all productions.
-    // Complexity: O(s) on first call, O(1) on subsequent calls
+    // Complexity: O(nps) on first call, O(1) on subsequent calls
     void prepareFirst() const;
 
     // Returns the first set of a sequence of symbols.
     // The first call is slower due to multiple first set calculations,
     // but subsequent calls are faster due to caching, until invalidated.
-    // Complexity: O(s + L) on first call, O(L) on subsequent calls
+    // Complexity: O(nps + sL) on first call, O(sL) on subsequent calls
     std::unordered_set<Symbol> first(const BNF&) const;
 
     // Returns the follow set of a given non-terminal.
@@ -128,18 +207,23 @@ public:
     // but subsequent calls are faster due to caching, until invalidated.
     // Returns an empty set for terminals.
     // Complexity:
-    //     O(np^2) on first call if it's a non-terminal,
-    //     O(1) on subsequent calls or if it's a terminal
+    //     O(nps) on first call if it's a non-terminal,
+    //     O(s) on subsequent calls or if it's a terminal
     std::unordered_set<Symbol> follow(const Symbol&) const;
 
     // Checks if a sequence of symbols is able to derive the empty string.
-    // Complexity: O(s + L) on first call, O(L) on subsequent calls
+    // Complexity: O(nps + L) on first call, O(L) on subsequent calls
     bool nullable(const BNF&) const;
 
+    // Returns the number of edges of the dependency graphs kept by the
+    // analysis, which doesn't depend on the order of the productions.
+    // Complexity: O(nps) on first call, O(s) on subsequent calls
+    std::size_t numDependencies() const;
+
     // Checks if a given non-terminal is endable, i.e, can be the
     // last symbol of a derivation sequence. Returns false for terminals.
     // Complexity:
-    //     O(np^2) on first call if it's a non-terminal,
+    //     O(nps) on first call if it's a non-terminal,
     //     O(1) on subsequent calls or if it's a terminal
     bool endable(const Symbol&) const;
 
@@ -199,57 +283,141 @@ public:
 
 private:
     std::vector<Production> productions;
-    std::unordered_map<Symbol, std::vector<std::size_t>> productionsBySymbol;
+    std::vector<Symbol> symbolNames;
+    std::unordered_map<Symbol, SymbolId> symbolIds;
+    std::vector<bool> terminalById;
+    std::vector<std::vector<std::size_t>> productionsBySymbol;
+    std::vector<std::vector<std::size_t>> usagesBySymbol;
     std::unordered_set<Symbol> nonTerminals;
     std::unordered_set<Symbol> terminals;
-    mutable bool isFirstValid = false;
-    mutable bool isFollowValid = false;
-    mutable std::unordered_map<Symbol, bool> nullabilityBySymbol;
-    mutable std::unordered_map<Symbol, std::unordered_set<Symbol>> followSet;
-    mutable std::unordered_set<Symbol> endableNonTerminals;
+    mutable bool isAnalysisValid = false;
+    mutable std::vector<bool> nullabilityBySymbol;
+    mutable std::vector<IndexList> firstSet;
+    mutable std::vector<IndexList> followSet;
+    // Size of the bitsets above, with room for new symbols
+    mutable std::size_t capacity = 0;
+
+    // Dependency graphs kept by the analysis, so that it can be updated
+    // when a production is added:
+    //   pendingSymbols[p]: number of symbols of production p that aren't
+    //     known to be nullable yet;
+    //   nullableOccurrences[a]: productions waiting for a to be nullable;
+    //   firstUsers[a]: productions whose first set includes first(a);
+    //   followUsers[a]: non-terminals whose follow set includes first(a);
+    //   followEdges[a]: non-terminals whose follow set includes follow(a).
+    // Nullability only grows between full analyses, so the edges of a
+    // production only grow as well. nullableSince[a] is the tick in which
+    // a became nullable and linkedAt[p] the one in which p was last
+    // linked, which tells apart the edges that p already has.
+    // A value added to the first/follow set of a symbol
+    using Change = std::pair<SymbolId, SymbolId>;
+    mutable std::vector<std::size_t> pendingSymbols;
+    mutable std::vector<std::vector<std::size_t>> nullableOccurrences;
+    mutable std::vector<std::vector<std::size_t>> firstUsers;
+    mutable std::vector<std::vector<SymbolId>> followUsers;
+    mutable std::vector<std::vector<SymbolId>> followEdges;
+    mutable std::vector<std::size_t> nullableSince;
+    mutable std::vector<std::size_t> linkedAt;
+    mutable std::size_t ticks = 0;
 
     std::shared_ptr<const CFGRepresentation> representation;
     static std::shared_ptr<const CFGRepresentation> defaultRepresentation;
 
     const CFGRepresentation& getRepresentation() const;
 
-    CFG& internalAdd(const Production&);
+    CFG& internalAdd(Production);
+
+    // Adds a production whose symbols are already interned.
+    CFG& addInterned(Production);
+
+    // Returns the id of a symbol, interning it if necessary.
+    SymbolId intern(const Symbol&);
+
+    // Converts a sequence of symbols to ids. Symbols that aren't used
+    // in this CFG are mapped to npos.
+    std::vector<SymbolId> toIds(const std::vector<Symbol>&) const;
+
+    // Converts a set of ids to symbols. Ids beyond the last
+    // symbol are ignored.
+    std::unordered_set<Symbol> toSymbols(const IndexList&) const;
 
     // Utility methods that map to the representation scheme methods.
     std::vector<Symbol> toSymbolSequence(const BNF&) const;
     std::string name(const Symbol&) const;
 
-    // Executes a callback for all productions of a given symbol.
-    // Complexity: O(f), where f is the complexity of the callback.
-    void select(const Symbol&, const std::function<void(const Production&)>&) const;
+    // Returns the productions of a symbol, which is empty for
+    // terminals and undefined non-terminals.
+    const std::vector<std::size_t>& productionsOf(const Symbol&) const;
+
+    // Calculates the nullability, first and follow sets of all symbols
+    // of this CFG, as well as the first set of each production.
+    // Complexity: O(nps) on first call, O(1) on subsequent calls
+    void analyze() const;
+
+    // Updates the analysis after a production is added, given its index.
+    // Only the values added to each set are propagated.
+    // Complexity: O(c), where c is the number of values added to all
+    // sets, times the number of dependencies of each of them
+    void update(std::size_t) const;
+
+    // Resizes the analysis structures to fit newly interned symbols.
+    // Bitsets are only resized when they run out of capacity.
+    // Complexity: O(n + s) if the bitsets are resized, O(1) otherwise
+    void grow() const;
+
+    // Returns the capacity of the bitsets for a number of symbols.
+    static std::size_t capacityFor(std::size_t);
+
+    // Calculates the nullability of all symbols. Each production keeps
+    // a counter of the symbols that aren't known to be nullable yet.
+    // Complexity: O(np)
+    void updateNullability() const;
+
+    // Registers a production in the nullability counters, pushing its
+    // name to a worklist if it becomes nullable.
+    // Complexity: O(p)
+    void registerNullability(std::size_t, std::vector<SymbolId>&) const;
+
+    // Pops a newly nullable symbol of a worklist, updating the counters
+    // of the productions that use it.
+    // Complexity: O(n)
+    void propagateNullability(std::vector<SymbolId>&) const;
+
+    // Marks a production as nullable, pushing its name to a worklist
+    // if it wasn't nullable yet.
+    // Complexity: O(1)
+    void markNullable(std::size_t, std::vector<SymbolId>&) const;
 
-    // Returns the first set of a vector of symbols.
-    // Complexity: O(s + L) on first call, O(L) on subsequent calls
-    std::unordered_set<Symbol> groupedFirst(const std::vector<Symbol>&) const;
+    // Adds the dependency edges of a production that it doesn't have yet.
+    // If worklists are given, also merges the sets along these edges,
+    // pushing the new values of the first/follow sets that changed.
+    // Complexity: O(p^2) without worklists, O(p^2.s) otherwise
+    void link(std::size_t, std::vector<Change>*, std::vector<Change>*) const;
 
-    // Calculates the first set of all non-terminals of this CFG.
-    // Complexity: O(s) on first call, O(1) on subsequent calls
+    // Calculates the first set of all symbols, propagating the first
+    // set of each non-terminal to the ones that may start with it.
+    // Complexity: O(nps)
     void updateFirst() const;
 
-    // Checks if a vector of symbols is able to derive the empty string.
-    // Complexity: O(s + L) on first call, O(L) on subsequent calls
-    bool groupedNullable(const std::vector<Symbol>&) const;
+    // Calculates the follow set of all symbols, propagating the follow
+    // set of each non-terminal to the ones that may end it.
+    // Complexity: O(nps)
+    void updateFollow() const;
 
-    // Updates the nullability information about a production
-    // and all other productions it references.
-    // Complexity: O(s)
-    void updateNullability(std::size_t, std::unordered_set<std::size_t>&, std::unordered_map<Symbol, bool>&) const;
+    // Checks if a vector of symbols is able to derive the empty string.
+    // Complexity: O(nps + L) on first call, O(L) on subsequent calls
+    bool groupedNullable(const std::vector<SymbolId>&) const;
 
     // Updates the range information about a production and all
     // other productions it references.
     // Complexity: O(s)
-    void populateRange(std::size_t, std::unordered_set<Symbol>&, std::unordered_set<std::size_t>&) const;
+    void populateRange(std::size_t, IndexList&, std::vector<bool>&) const;
 
     // Updates the range information about a symbol and all
     // other symbols it references.
     // Complexity: O(s)
-    bool populateRangeBySymbol(const Symbol&, std::unordered_set<Symbol>&,
-        std::unordered_set<std::size_t>&, bool = true) const;
+    bool populateRangeBySymbol(SymbolId, IndexList&,
+        std::vector<bool>&, bool = true) const;
 
     // Invalidates all cached structures.
     // Complexity: O(1)
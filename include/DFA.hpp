@@ -6,6 +6,7 @@
 #include <queue>
 #include <unordered_map>
 #include <unordered_set>
+#include "TransitionTable.hpp"
 #include "utils.hpp"
 
 class DFA;
@@ -65,12 +66,14 @@ public:
     template<typename... Args>
     DFA& accept(State& state, Args... args) {
         state.accepts = true;
+        invalidate();
         accept(args...);
         return *this;
     }
     template<typename... Args>
     DFA& accept(State&& state, Args... args) {
         states[states[state]].accepts = true;
+        invalidate();
         accept(args...);
         return *this;
     }
@@ -98,6 +101,21 @@ public:
     // Reads a character, transitioning according to it.
     void read(char);
 
+    // Returns a frozen, array-backed form of this DFA, in which states
+    // are numbered densely in iteration order. The result is cached
+    // until this DFA is modified.
+    // Complexity: O(kn + m) on first call, O(1) on subsequent calls
+    const TransitionTable& compile() const;
+
+    // Checks if this DFA accepts an input, without changing its current state.
+    // Complexity: O(L) plus the cost of compile(), where L is the input length
+    bool run(const std::string&) const;
+
+    // Checks each input of a list, returning the results in the same order.
+    // Doesn't change the current state of this DFA.
+    // Complexity: O(L) plus the cost of compile(), where L is the total length
+    std::vector<bool> matchAll(const std::vector<std::string>&) const;
+
     // Checks if this DFA is in a final state.
     bool accepts() const;
 
@@ -108,9 +126,14 @@ public:
     DFA& removeTransition(const State&, char);
 
     // Returns all characters used in transitions in this DFA.
-    // Complexity: O(m)
+    // Complexity: O(m.log k) on first call, O(k) on subsequent calls
     std::unordered_set<char> alphabet() const;
 
+    // Returns the partition of all bytes into classes of bytes that
+    // behave identically in every state. Cached until this DFA is modified.
+    // Complexity: O(m.log k) on first call, O(1) on subsequent calls
+    const ByteClasses& classes() const;
+
     // Returns a set containing all final states of this DFA.
     std::unordered_set<State> finalStates() const;
 
@@ -129,11 +152,11 @@ public:
     DFA withoutUselessStates() const;
 
     // Returns a DFA equivalent to this one, but without equivalent states.
-    // Complexity: O(kn.log n + m), where k is the size of the alphabet
+    // Complexity: O(kn.log n + m), where k is the number of byte classes
     DFA withoutEquivalentStates();
 
     // Returns the minimized form of this DFA.
-    // Complexity: O(kn.log n + m), where k is the size of the alphabet
+    // Complexity: O(kn.log n + m), where k is the number of byte classes
     DFA minimized() const;
 
     // Checks if this DFA is empty, i.e, doesn't accept anything.
@@ -188,11 +211,30 @@ private:
     Index currentState;
     Index initialStateIndex;
     bool errorState = true;
+    mutable bool isTableValid = false;
+    mutable bool isClassesValid = false;
+    mutable ByteClasses byteClasses;
+    mutable std::unordered_set<char> sigma;
+    mutable TransitionTable table;
+    mutable std::vector<Index> tableToIndex;
+    mutable std::unordered_map<Index, TransitionTable::Index> indexToTable;
     const static std::string errorStateName;
     const static std::string materializedErrorPrefix;
 
     void accept() {}
 
+    // Invalidates the cached transition table and byte classes.
+    // Complexity: O(1)
+    void invalidate();
+
+    // Calculates the byte classes and the alphabet of this DFA.
+    // Complexity: O(m.log k) on first call, O(1) on subsequent calls
+    void updateClasses() const;
+
+    // Returns one character of each byte class used in transitions.
+    // Complexity: O(k) plus the cost of updateClasses()
+    std::vector<char> classRepresentatives() const;
+
     // Returns the index of the error state, or -1 if it's not materialized.
     // Complexity: O(n)
     Index errorStateIndex() const;
@@ -207,14 +249,10 @@ private:
     // Complexity: O(n + m)
     IndexList getReachableStates() const;
 
-    // Returns the equivalence classes of this DFA.
-    // Complexity: O(kn.log n), where k is the size of the alphabet
-    std::queue<IndexList> getEquivalenceClasses();
-
-    // Returns the set of states that, when reading a given input,
-    // go to a state of a given set.
-    // Complexity: O(m)
-    IndexList stateFilter(char, const IndexList&) const;
+    // Returns the equivalence classes of this DFA, using Hopcroft's
+    // algorithm with inverse transition lists and a refinable partition.
+    // Complexity: O(kn.log n), where k is the number of byte classes
+    std::vector<std::vector<Index>> getEquivalenceClasses();
 
     // Executes breadth-first search on a state, returning a set
     // containing all states that are reachable from it.
@@ -16,11 +16,26 @@
 class IndexList {
 public:
     using ull = unsigned long long;
-    IndexList(ull);
+    // Creates a list of a given size, which starts with all
+    // values set unless stated otherwise.
+    IndexList(ull, bool = true);
+    IndexList& insert(ull);
+    // Changes the size of this list. New values start unset.
+    IndexList& resize(ull);
     IndexList& remove(ull);
     ull extract();
     bool isSet(ull) const;
+    bool empty() const;
     ull count() const;
+    // Adds all values of another list to this one, returning true if any
+    // of them was new. Values beyond the size of this list are ignored.
+    bool merge(const IndexList&);
+    // Same as above, but also calls a function for each new value.
+    bool merge(const IndexList&, const std::function<void(ull)>&);
+    // Checks if this list has any value in common with another one.
+    bool intersects(const IndexList&) const;
+    // Calls a function for each value of this list, in increasing order.
+    void forEach(const std::function<void(ull)>&) const;
     std::size_t hash() const;
     std::string debug() const;
     IndexList operator!() const;
@@ -3,12 +3,18 @@
 #ifndef LEXER_HPP
 #define LEXER_HPP
 
+#include <bitset>
+#include <functional>
+#include <istream>
 #include <ostream>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
+#include "MappedFile.hpp"
 #include "Regex.hpp"
+#include "TransitionTable.hpp"
 
 struct Token {
 	std::string type;
@@ -23,28 +29,228 @@ inline std::ostream& operator<<(std::ostream& stream, const Token& token) {
 	return stream << "Token(" + token.type + ", " + token.content + ")";
 }
 
+// A token that refers to its content as a range of the input instead
+// of copying it. The type is an id given by Lexer::tokenId.
+struct TokenSpan {
+	std::size_t type;
+	std::size_t offset;
+	std::size_t length;
+};
+
+inline bool operator==(const TokenSpan& lhs, const TokenSpan& rhs) {
+	return lhs.type == rhs.type && lhs.offset == rhs.offset
+		&& lhs.length == rhs.length;
+}
+
 class Lexer {
 public:
 	using TokenType = std::string;
+	using TokenId = std::size_t;
 	using Expression = std::string;
 
 	void ignore(char);
-	void addToken(const TokenType&, const Expression&);
+
+	// Adds a token type. When several types match the longest token,
+	// the one with the highest priority wins, and types with the same
+	// priority are resolved in registration order (the first one wins).
+	void addToken(const TokenType&, const Expression&, int = 0);
 	void removeToken(const TokenType&);
 	bool accepts() const;
 	const std::string& getError() const;
 	std::vector<Token> read(const std::string&);
+
+	// Splits an input into tokens without copying their contents.
+	// Ignored characters surrounding a token are left out of its span,
+	// but the ones inside it are kept (see content()).
+	// Complexity: O(L), where L is the length of the input
+	std::vector<TokenSpan> scan(const char*, std::size_t);
+	std::vector<TokenSpan> scan(const std::string&);
+
+	// Splits the contents of a mapped file into tokens. The spans refer
+	// to the mapping, so the file must outlive them.
+	std::vector<TokenSpan> scan(const MappedFile&);
+
+	// Same as scan, but splits the input into chunks that are scanned
+	// by several threads. Each chunk guesses that a token starts at its
+	// first delimiter; when the previous chunk shows that the guess was
+	// wrong, it's scanned again from the right position until both agree.
+	// Complexity: O(L / t) when the guesses are right, where t is the
+	// number of threads, and O(L) in the worst case
+	std::vector<TokenSpan> scanParallel(const char*, std::size_t,
+		unsigned = std::thread::hardware_concurrency());
+	std::vector<TokenSpan> scanParallel(const std::string&,
+		unsigned = std::thread::hardware_concurrency());
+	std::vector<TokenSpan> scanParallel(const MappedFile&,
+		unsigned = std::thread::hardware_concurrency());
+
+	// Returns the id of a token type, which stays the same for the
+	// lifetime of this lexer, even if the type is removed.
+	TokenId tokenId(const TokenType&);
+
+	// Returns the name of a token type id.
+	const TokenType& typeName(TokenId) const;
+
+	// Returns the content of a token span, without ignored characters.
+	std::string content(const TokenSpan&, const char*) const;
+	std::string content(const TokenSpan&, const std::string&) const;
+	std::string content(const TokenSpan&, const MappedFile&) const;
+
+	// Converts a token span to a token.
+	Token materialize(const TokenSpan&, const std::string&) const;
+
 	void addDelimiters(const std::initializer_list<char>&);
 	void addDelimiters(const std::string&);
 
+	// Tokenizes an input that arrives in chunks (see below).
+	class Stream;
+
+private:
+	// The progress of reading a token that starts at a given index.
+	// Once it's complete, next holds the index where the following
+	// one starts and token has length 0 if only ignored characters
+	// were found.
+	struct Cursor {
+		std::size_t start;
+		std::size_t position;
+		TransitionTable::Index state;
+		TransitionTable::Tag type;
+		std::size_t firstIndex;
+		std::size_t maxIndex;
+		bool foundRelevantSymbol;
+		std::size_t next;
+		TokenSpan token;
+		// The (position, state) pairs read since the last accepting
+		// one (see below)
+		std::vector<std::pair<std::size_t, TransitionTable::Index>> trail;
+	};
+
+	// Pairs of (input position, DFA state) from which a token was
+	// previously read up to its end without accepting again. Meeting
+	// one of them means the current token can't get any longer, so
+	// no suffix of the input is scanned twice and maximal munch takes
+	// linear time (T. Reps, "Maximal-munch tokenization in linear time").
+	// As in Reps's table, they're bits indexed by position and state,
+	// but only over the positions from the current token on, since
+	// scanning never goes back before it.
+	class Failures {
+	public:
+		explicit Failures(std::size_t numStates = 0);
+
+		// Complexity: O(1)
+		bool contains(std::size_t position, TransitionTable::Index state) const {
+			if (position < base || position - base >= numRows) {
+				return false;
+			}
+			std::size_t word = (position - base) * rowSize + state / 64;
+			return (bits[word] >> (state % 64)) & 1;
+		}
+
+		// Complexity: O(1) amortized
+		void insert(std::size_t, TransitionTable::Index);
+
+		// Forgets the pairs before a position.
+		// Complexity: O(1) amortized
+		void discardBefore(std::size_t);
+
+		// Forgets the pairs before a position, making the other ones
+		// relative to it.
+		void rebase(std::size_t);
+
+		void clear();
+
+	private:
+		std::size_t rowSize;
+		std::size_t base = 0;
+		std::size_t numRows = 0;
+		std::vector<unsigned long long> bits;
+
+		void erase(std::size_t);
+	};
+
+	// A part of the input scanned in parallel. Scanning starts at begin
+	// and goes on until a token would start at or after end, which is
+	// where it stops. Each token start is kept along with the number of
+	// tokens found before it, so that the results can be joined at any
+	// of them.
+	struct Chunk {
+		std::size_t begin;
+		std::size_t end;
+		std::size_t stop;
+		std::vector<std::pair<std::size_t, std::size_t>> starts;
+		std::vector<TokenSpan> tokens;
+		std::string error;
+	};
+
+	// The minimum size of a chunk worth its own thread
+	const static std::size_t minChunkSize = 1 << 16;
+
+	struct TokenRule {
+		TokenId id;
+		int priority;
+		Regex regex;
+	};
+
+	// Token types sorted by decreasing priority, then by registration
+	// order, which is the order used to break ties between them
+	std::vector<TokenRule> tokenTypes;
+	std::vector<TokenType> typeNames;
+	std::unordered_map<TokenType, TokenId> typeIds;
+	std::bitset<256> blacklist;
+	std::bitset<256> delimiters;
+	std::string errorMessage;
+	// All token types compiled into a single DFA, whose final states
+	// are tagged with the index of the recognized type, with ties
+	// already resolved
+	TransitionTable automaton;
+	bool isAutomatonValid = false;
+
+	void compile();
+	Cursor cursorAt(std::size_t) const;
+
+	// Continues reading a token. Returns false if the input ended before
+	// the token could be completed and more of it may still come, or
+	// throws the error message if no token matches.
+	bool advance(Cursor&, const char*, std::size_t, bool, Failures&) const;
+	void scanChunk(Chunk&, const char*, std::size_t) const;
+	std::string error(const char*, std::size_t, std::size_t) const;
+};
+
+/*
+ * Tokenizes an input that arrives in chunks, passing each token to a
+ * callback as soon as it's complete. Only the token being read is
+ * kept in memory, so it works on inputs of any size. Token offsets
+ * are relative to the start of the whole input. The lexer must not
+ * be changed while a stream is in use.
+ */
+class Lexer::Stream {
+public:
+	using Callback = std::function<void(const TokenSpan&, const std::string&)>;
+
+	Stream(Lexer&, const Callback&);
+
+	// Reads a chunk of the input.
+	void feed(const char*, std::size_t);
+	void feed(const std::string&);
+
+	// Reads an input stream until it ends, in chunks of a given size.
+	void feed(std::istream&, std::size_t = 1 << 16);
+
+	// Signals the end of the input, flushing the last token.
+	void finish();
+
+	bool accepts() const;
+	const std::string& getError() const;
+
 private:
-	std::unordered_map<TokenType, Regex> tokenTypes;
-	std::unordered_set<char> blacklist;
-	std::vector<Regex> delimiters;
+	Lexer& lexer;
+	Callback callback;
+	std::string buffer;
+	std::size_t bufferOffset = 0;
+	Cursor cursor;
+	Failures failures;
 	std::string errorMessage;
 
-	std::pair<std::size_t, Token> readNext(std::size_t, const std::string&);
-	std::string error(const std::string&, std::size_t, std::size_t) const;
+	void run(bool);
 };
 
 #endif
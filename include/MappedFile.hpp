@@ -0,0 +1,40 @@
+/* created by Ghabriel Nunes <ghabriel.nunes@gmail.com> [2016] */
+
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include <string>
+
+/*
+ * A read-only view of a file mapped into memory, which lets its contents
+ * be read without copying them. The kernel is advised that the mapping
+ * will be read sequentially, so it can read ahead aggressively and drop
+ * pages that were already read.
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const std::string&);
+    MappedFile(MappedFile&&);
+    MappedFile(const MappedFile&) = delete;
+    ~MappedFile();
+    MappedFile& operator=(MappedFile&&);
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Checks if the file was successfully opened and mapped.
+    bool isOpen() const;
+
+    // Returns the contents of the file.
+    const char* data() const;
+
+    // Returns the size of the file.
+    std::size_t size() const;
+
+private:
+    const char* memory = nullptr;
+    std::size_t length = 0;
+    bool opened = false;
+
+    void unmap();
+};
+
+#endif
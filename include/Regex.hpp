@@ -3,18 +3,31 @@
 #ifndef REGEX_HPP
 #define REGEX_HPP
 
+#include <bitset>
 #include <climits>
 #include <deque>
+#include <map>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
+#include "DFA.hpp"
+#include "TransitionTable.hpp"
 
 class Regex {
 public:
+    // The way input is matched: simulating the NFA directly, running
+    // a DFA compiled from it at construction time or building the DFA
+    // states lazily, as the input reaches them.
+    enum class Mode {
+        NFA,
+        DFA,
+        LAZY
+    };
+
     Regex();
-    explicit Regex(const std::string&);
+    explicit Regex(const std::string&, Mode = Mode::NFA);
     void read(char);
     bool matches(char);
     bool matches(const std::string&);
@@ -22,6 +35,25 @@ public:
     bool aborted() const;
     void reset();
 
+    // Returns a DFA that recognizes the same language as this regex,
+    // built with the powerset construction. Its states are named
+    // q0, q1, ..., where q0 is the initial state.
+    // Complexity: O(2^n) in the worst case, where n is the number of
+    // NFA states, but usually close to the size of the result.
+    DFA toDFA() const;
+
+    // Sets the maximum number of DFA states kept by the lazy mode.
+    // When it's exceeded, the cache is flushed and rebuilt on demand.
+    // Each cached state takes roughly 256 * sizeof(long) bytes plus
+    // the size of its set of NFA states.
+    void setCacheLimit(std::size_t);
+
+    // Builds a single DFA recognizing the union of several regexes. Each
+    // final state is tagged with the position, in the list, of the first
+    // regex that accepts in it.
+    // Complexity: the same as toDFA, where n is the total number of states
+    static TransitionTable combine(const std::vector<const Regex*>&);
+
 private:
     using Pattern = std::string;
     struct State {
@@ -29,6 +61,8 @@ private:
         std::size_t read(char) const;
         std::unordered_map<Pattern, std::size_t> transitions;
         std::unordered_set<std::size_t> spontaneous;
+        // The bytes accepted by each transition, compiled from its pattern
+        std::vector<std::pair<std::bitset<256>, std::size_t>> compiled;
     };
     struct Composition {
         Pattern pattern;
@@ -40,19 +74,77 @@ private:
         std::vector<std::size_t> next;
         bool ready = false;
     };
+    // DFA states built on demand by the lazy mode. Each one is a sorted
+    // set of NFA states with a row of 256 transitions, where unknown
+    // marks transitions that haven't been calculated yet.
+    struct LazyCache {
+        const static long unknown = -2;
+        std::map<std::vector<std::size_t>, long> ids;
+        std::vector<std::vector<std::size_t>> subsets;
+        std::vector<long> transitions;
+        std::vector<bool> accepting;
+        std::size_t limit = 4096;
+    };
 
     const static std::string PATTERN_OR;
     const static std::string PATTERN_CONTEXT_START;
     const static std::string PATTERN_CONTEXT_END;
     const static std::string PATTERN_WILDCARD;
     std::string expression;
+    Mode mode = Mode::NFA;
     std::vector<State> stateList;
-    std::unordered_set<std::size_t> currentStates;
+    using Word = unsigned long long;
+    const static std::size_t wordSize = 64;
+    std::vector<std::vector<std::size_t>> closures;
+    // The NFA is simulated with bit vectors of numWords words each:
+    // every state has the mask of its epsilon-closure and a row of
+    // targets indexed by byte class (INT_MAX meaning no transition).
+    ByteClasses byteClasses;
+    std::size_t numWords = 0;
+    std::vector<Word> closureMasks;
+    std::vector<std::size_t> nfaTargets;
+    std::vector<Word> currentStates;
+    std::vector<Word> nextStates;
     std::size_t acceptingState;
+    TransitionTable table;
+    TransitionTable::Index dfaState = TransitionTable::dead;
+    LazyCache cache;
 
     void build(std::deque<Composition>&);
-    void expandSpontaneous(std::unordered_set<std::size_t>&) const;
+
+    // Calculates the (sorted) epsilon-closure of every state,
+    // both as a list and as a bit mask.
+    void buildClosures();
+
+    // Fills the table of NFA targets by byte class.
+    void buildTargets();
+
+    // Checks if a state belongs to a bit vector.
+    static bool isSet(const Word* states, std::size_t index) {
+        return (states[index / wordSize] >> (index % wordSize)) & 1;
+    }
+
+    // Builds the transition table of the DFA equivalent to the NFA
+    // of this regex, using the cached epsilon-closures.
+    TransitionTable powerset() const;
+
+    // Returns the sorted set of states reached from a sorted set
+    // of states by reading a character, including epsilon-closures.
+    std::vector<std::size_t> step(const std::vector<std::size_t>&, char) const;
+
+    // Transitions the lazy DFA, building the target state if needed.
+    void lazyRead(char);
+
+    // Returns the id of a lazy DFA state, adding it to the cache if
+    // necessary. Returns true in the second field if the cache was flushed.
+    std::pair<long, bool> lazyFind(std::vector<std::size_t>&&);
+
+    // Empties the lazy cache, keeping only the initial state (id 0).
+    void flush();
     void debug(const Composition&) const;
+
+    // Returns the set of bytes accepted by a pattern.
+    static std::bitset<256> compilePattern(const Pattern&);
 };
 
 #endif
@@ -0,0 +1,85 @@
+/* created by Ghabriel Nunes <ghabriel.nunes@gmail.com> [2016] */
+
+#ifndef TRANSITIONTABLE_HPP
+#define TRANSITIONTABLE_HPP
+
+#include <array>
+#include <string>
+#include <vector>
+#include "ByteClasses.hpp"
+
+/*
+ * A frozen, array-backed deterministic automaton. States are numbered
+ * densely in the range [0, size) and transitions are stored in a single
+ * states x classes table, where each input byte is mapped to its byte class
+ * (see ByteClasses) through a 256-entry array. Missing transitions point to
+ * the dead state (-1). Reading a byte costs one class lookup and one table
+ * load. Final states carry a non-negative tag, which tells apart the
+ * patterns of a combined automaton (see Regex::combine).
+ */
+class TransitionTable {
+public:
+    using Index = long;
+    using ColumnMap = ByteClasses::ClassMap;
+    using Tag = long;
+    const static Index dead = -1;
+    const static Tag untagged = -1;
+
+    TransitionTable();
+    TransitionTable(std::size_t, const ByteClasses&);
+
+    // Returns the number of states of this table.
+    std::size_t size() const;
+
+    // Returns the number of columns of this table.
+    std::size_t columns() const;
+
+    // Returns/sets the initial state.
+    Index initialState() const;
+    void initialState(Index);
+
+    // Adds a transition to this table. Since bytes that share a column
+    // are indistinguishable, this affects all of them.
+    void addTransition(Index, Index, char);
+
+    // Marks a state as final, optionally with a tag.
+    void accept(Index, Tag = 0);
+
+    // Checks if a state is final.
+    bool accepts(Index state) const {
+        return tag(state) != untagged;
+    }
+
+    // Returns the tag of a state, or untagged if it's not final.
+    Tag tag(Index state) const {
+        return state == dead ? untagged : tags[state];
+    }
+
+    // Returns the state reached by reading a byte in a given state.
+    Index next(Index state, char input) const {
+        return table[state * numColumns + columnMap[static_cast<unsigned char>(input)]];
+    }
+
+    // Runs this table on a range of bytes starting from a given state,
+    // returning the state it ends in (or dead if it gets stuck).
+    // Complexity: O(L), where L is the length of the input
+    Index run(const char*, const char*, Index) const;
+    Index run(const std::string&) const;
+
+    // Checks if this table accepts an input.
+    // Complexity: O(L), where L is the length of the input
+    bool matches(const std::string&) const;
+
+    // Checks each input of a list, returning the results in the same order.
+    // Complexity: O(L), where L is the sum of the input lengths
+    std::vector<bool> matchAll(const std::vector<std::string>&) const;
+
+private:
+    std::vector<Index> table;
+    std::vector<Tag> tags;
+    ColumnMap columnMap;
+    std::size_t numColumns;
+    Index initialStateIndex;
+};
+
+#endif
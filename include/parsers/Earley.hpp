@@ -0,0 +1,112 @@
+/* created by Ghabriel Nunes <ghabriel.nunes@gmail.com> [2016] */
+
+#ifndef EARLEY_HPP
+#define EARLEY_HPP
+
+#include <vector>
+#include "Parser.hpp"
+
+namespace parser {
+    /*
+     * An Earley recognizer, which accepts any context-free grammar.
+     * Nullable symbols are skipped as soon as they're expected (Aycock and
+     * Horspool), so completions never look at the current set, and
+     * deterministic chains of completions are collapsed into their topmost
+     * item (Leo), which makes right recursion linear. The sets are stored
+     * contiguously in a few flat arrays, indexed per position; items are
+     * deduplicated through per-rule chains instead of hash sets.
+     */
+    class Earley : public Parser {
+    public:
+        using Parser::Symbol;
+        using Parser::TokenType;
+        using SymbolId = CFG::SymbolId;
+
+        Earley(const CFG&);
+        ParseResults parse(const std::vector<Token>&) override;
+        bool canParse() const override;
+
+        // Same as above, but the input is given as terminal ids of the CFG
+        // (see terminalIds()), which aren't looked up by name.
+        ParseResults parse(const std::vector<SymbolId>&);
+
+        // Returns the number of items of the sets of the last parse, which
+        // grows linearly with the input on LR(k) grammars.
+        std::size_t numItems() const;
+
+    private:
+        const static std::size_t none = -1;
+
+        // A production with a dot in its right side. Rules of the same
+        // production are numbered consecutively, and the last production
+        // is an implicit <S'> ::= <S>.
+        struct Rule {
+            std::size_t production;
+            SymbolId next;
+        };
+
+        struct Item {
+            unsigned rule;
+            std::size_t origin;
+            // Next item of the same set with the same rule
+            std::size_t sameRule;
+        };
+
+        // The topmost item of a deterministic chain of completions
+        // started by a symbol in a set.
+        struct LeoItem {
+            SymbolId symbol;
+            unsigned rule;
+            std::size_t origin;
+        };
+
+        std::vector<Rule> rules;
+        std::vector<unsigned> firstRule;
+        std::vector<SymbolId> names;
+        std::vector<bool> nullable;
+        unsigned acceptRule;
+        // Name of the end of the input in errors, which the CFG doesn't use
+        TokenType endName;
+
+        // Set i is items[setStart[i], setStart[i + 1]). The items waiting
+        // for each symbol and the Leo items of a set are kept sorted by
+        // symbol in the same way.
+        std::vector<Item> items;
+        std::vector<std::size_t> setStart;
+        std::vector<std::pair<SymbolId, std::size_t>> waiting;
+        std::vector<std::size_t> waitingStart;
+        std::vector<LeoItem> leoItems;
+        std::vector<std::size_t> leoStart;
+
+        // Per-rule and per-symbol marks of the set being built
+        std::vector<std::size_t> ruleHead;
+        std::vector<std::size_t> ruleMark;
+        std::vector<std::size_t> predicted;
+
+        // Runs the recognizer over tokens or terminal ids.
+        template<typename T>
+        ParseResults run(const std::vector<T>&);
+
+        // Returns the terminal id of a token, or npos if it's not a
+        // terminal of the CFG.
+        SymbolId terminal(const Token&) const;
+        SymbolId terminal(SymbolId) const;
+
+        // Adds an item to the last set, unless it's already there.
+        void add(unsigned, std::size_t);
+
+        // Predicts and completes the items of the last set.
+        void process();
+
+        // Indexes the waiting items of the last set and finds its Leo items.
+        void finish();
+
+        // Returns the waiting items of a set for a symbol, as a range.
+        std::pair<std::size_t, std::size_t> waitingFor(std::size_t, SymbolId) const;
+
+        // Returns the Leo item of a set for a symbol, or nullptr.
+        const LeoItem* leoFor(std::size_t, SymbolId) const;
+    };
+}
+
+#endif
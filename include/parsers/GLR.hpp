@@ -0,0 +1,150 @@
+/* created by Ghabriel Nunes <ghabriel.nunes@gmail.com> [2016] */
+
+#ifndef GLR_HPP
+#define GLR_HPP
+
+#include <unordered_map>
+#include <vector>
+#include "LALR1.hpp"
+
+namespace parser {
+    /*
+     * A generalized LR parser, which accepts any context-free grammar. It
+     * drives the LALR(1) table with its conflicts kept, forking the stack
+     * on every cell with more than one action. Stacks are merged into a
+     * graph-structured stack with at most one node per state and input
+     * position, so deterministic regions cost the same as in LALR1.
+     * Every derivation of the input is kept in a shared packed parse
+     * forest, in which each (symbol, start, end) has a single node.
+     */
+    class GLR : public LALR1 {
+    public:
+        const static std::size_t none = -1;
+
+        // A node of the forest, spanning the tokens [start, end). Token
+        // nodes have no symbol (npos) and no alternatives; the others have
+        // one packed node per way of deriving their span, linked through
+        // firstAlternative and PackedNode::next.
+        struct ForestNode {
+            SymbolId symbol;
+            std::size_t start;
+            std::size_t end;
+            std::size_t firstAlternative;
+        };
+
+        // A derivation of a forest node through a production. Its children
+        // are the forest nodes in children()[childrenBegin, childrenEnd).
+        struct PackedNode {
+            std::size_t production;
+            std::size_t next;
+            std::size_t childrenBegin;
+            std::size_t childrenEnd;
+        };
+
+        GLR(const CFG&);
+        ParseResults parse(const std::vector<Token>&) override;
+
+        // Same as above, but the input is given as terminal ids of the CFG
+        // (see terminalIds()).
+        ParseResults parse(const std::vector<SymbolId>&);
+
+        // Returns the forest built by the last successful parse, along with
+        // the index of its root. Productions are numbered as in the CFG.
+        const std::vector<ForestNode>& forest() const;
+        const std::vector<PackedNode>& packedNodes() const;
+        const std::vector<std::size_t>& children() const;
+        std::size_t root() const;
+
+        // Returns the number of stack nodes visited by the reductions of
+        // the last parse, which grows linearly with the input if the
+        // grammar is LR(1).
+        std::size_t numSteps() const;
+
+    private:
+        // The table has conflicts, so it can't build a single tree: the
+        // tree overload of LRParser is hidden, and forest() must be used.
+        using LALR1::parse;
+
+        // The links of a node are chained through Link::next, and the
+        // ones to nodes of the same position (i.e. labeled with empty
+        // symbols) are chained again through Link::nextLocal.
+        struct StackNode {
+            State state;
+            std::size_t position;
+            std::size_t firstLink;
+            std::size_t firstLocalLink;
+        };
+
+        // An edge of the stack, labeled with the forest node of the
+        // symbol it was created by.
+        struct Link {
+            std::size_t source;
+            std::size_t target;
+            std::size_t forestNode;
+            std::size_t next;
+            std::size_t nextLocal;
+        };
+
+        // A reduction to be done from a node. If a link is given, only the
+        // paths which include it are considered.
+        struct Reduction {
+            std::size_t node;
+            std::size_t production;
+            std::size_t link;
+        };
+
+        std::vector<StackNode> nodes;
+        std::vector<Link> links;
+        std::vector<std::size_t> frontier;
+        std::vector<std::size_t> nodeByState;
+        std::vector<Reduction> reductions;
+        std::vector<ForestNode> forestNodes;
+        std::vector<PackedNode> packed;
+        std::vector<std::size_t> packedChildren;
+        // Non-terminal nodes ending at the current position, by
+        // (non-terminal column, start)
+        std::unordered_map<unsigned long long, std::size_t> forestByKey;
+        // Links from the nodes of the current position, by (source, target)
+        std::unordered_map<unsigned long long, std::size_t> linkByNodes;
+        std::vector<std::size_t> path;
+        std::size_t position;
+        std::size_t rootNode = none;
+        std::size_t steps = 0;
+
+        // Runs the parser over tokens or terminal ids.
+        template<typename T>
+        ParseResults run(const std::vector<T>&);
+
+        // Calls a function for each action of a state on a terminal.
+        template<typename Callback>
+        void forEachAction(State, unsigned, const Callback&) const;
+
+        // Adds the reductions of a node to the worklist.
+        void enqueue(std::size_t, unsigned, std::size_t);
+
+        // Does a reduction, following every path of its length.
+        void reduce(const Reduction&, unsigned);
+
+        // Follows the paths of a given length from a node, reducing
+        // a production at the end of each of them.
+        void walk(std::size_t, std::size_t, std::size_t, bool, std::size_t, unsigned);
+
+        // Walks through a link, adding its forest node to the path.
+        void follow(std::size_t, std::size_t, std::size_t, bool, std::size_t, unsigned);
+
+        // Pushes the goto of a reduction on top of a node, whose children
+        // are the current path.
+        void push(std::size_t, std::size_t, unsigned);
+
+        // Returns the link between two nodes, or none. Only the links
+        // from the nodes of the current position are indexed.
+        std::size_t findLink(std::size_t, std::size_t) const;
+        std::size_t addLink(std::size_t, std::size_t, std::size_t);
+
+        static unsigned long long key(std::size_t high, std::size_t low) {
+            return (static_cast<unsigned long long>(high) << 32) | low;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,24 @@
+/* created by Ghabriel Nunes <ghabriel.nunes@gmail.com> [2016] */
+
+#ifndef LALR1_HPP
+#define LALR1_HPP
+
+#include "LRParser.hpp"
+
+namespace parser {
+    /*
+     * An LALR(1) parser. It shares the LR(0) collection with SLR1, but the
+     * lookaheads of each reduction are computed per state through the
+     * relations of DeRemer and Pennello (reads, includes and lookback).
+     */
+    class LALR1 : public LRParser {
+    public:
+        LALR1(const CFG&);
+
+    protected:
+        // Builds the table, optionally keeping its conflicts.
+        LALR1(const CFG&, bool keepConflicts);
+    };
+}
+
+#endif
@@ -3,8 +3,8 @@
 #ifndef LL1_HPP
 #define LL1_HPP
 
-#include <stack>
 #include <unordered_map>
+#include <vector>
 #include "Parser.hpp"
 
 namespace parser {
@@ -12,17 +12,56 @@ namespace parser {
     public:
         using Parser::Symbol;
         using Parser::TokenType;
+        using SymbolId = CFG::SymbolId;
 
         LL1(const CFG&);
         ParseResults parse(const std::vector<Token>&) override;
         bool canParse() const override;
 
+        // Same as above, but also builds the syntax tree of the input
+        // into a given tree, replacing its previous nodes.
+        ParseResults parse(const std::vector<Token>&, ParseTree&);
+
+        // Same as above, but the input is given as terminal ids of the CFG
+        // (see terminalIds()), which are mapped to columns without looking
+        // up their names.
+        ParseResults parse(const std::vector<SymbolId>&);
+        ParseResults parse(const std::vector<SymbolId>&, ParseTree&);
+
     private:
-        std::unordered_map<Symbol, std::unordered_map<TokenType, unsigned>> table;
+        // Stack entries are rows (non-terminals) in the range
+        // [0, numRows) and columns (terminals) shifted by numRows.
+        using Entry = unsigned;
+        const static unsigned noProduction = -1;
+
+        // A dense numRows x numColumns table of production indexes. The
+        // last two columns are the end of the sentence and unknown tokens.
+        std::vector<unsigned> table;
+        std::size_t numRows;
+        std::size_t numColumns;
+        std::unordered_map<TokenType, unsigned> columnByType;
+        // Column of each symbol id, where non-terminals are unknown
+        std::vector<unsigned> columnOf;
+        std::vector<Symbol> names;
+        // Right-hand side of each production, already reversed and
+        // converted to entries, where the production i is stored in
+        // [offsets[i], offsets[i + 1]).
+        std::vector<Entry> products;
+        std::vector<std::size_t> offsets;
+        // Symbol id of each entry, except the end of the sentence
+        std::vector<SymbolId> symbols;
+        std::vector<Entry> stack;
+        // Where the node of each stack entry must be stored
+        std::vector<ParseNode**> slots;
+        Entry start;
         bool conflict = false;
 
-        ParseResults unwind(std::stack<Symbol>&, const TokenType&);
-        ParseResults error(const std::vector<Token>&, std::size_t, const std::string&) const;
+        // Runs the parser over tokens or terminal ids, building a tree
+        // if one is given.
+        template<typename T>
+        ParseResults run(const std::vector<T>&, ParseTree*);
+        unsigned column(const Token&) const;
+        unsigned column(SymbolId) const;
     };
 }
 
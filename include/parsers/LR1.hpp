@@ -0,0 +1,43 @@
+/* created by Ghabriel Nunes <ghabriel.nunes@gmail.com> [2016] */
+
+#ifndef LR1_HPP
+#define LR1_HPP
+
+#include <vector>
+#include "IndexList.hpp"
+#include "LRParser.hpp"
+
+namespace parser {
+    /*
+     * An LR(1) parser whose states are built with Pager's method: a new
+     * state is merged into an existing one with the same LR(0) core if
+     * they are weakly compatible, i.e. merging their lookaheads can't
+     * introduce a reduce/reduce conflict. This accepts every LR(1) grammar
+     * while keeping the number of states close to the LALR(1) one.
+     */
+    class LR1 : public LRParser {
+    public:
+        LR1(const CFG&);
+
+    private:
+        // Returns the collection of merged LR(1) states, numbered in
+        // order of discovery and without unreachable ones.
+        std::vector<LR1State> collection() const;
+
+        // Expands a state whose kernel lookaheads are known, computing
+        // the lookaheads of the other items. positions must map each
+        // production to none, and is left that way.
+        void closure(LR1State&, std::vector<std::size_t>& positions) const;
+
+        // Adds the first set of a production suffix to a list, returning
+        // true if the suffix is nullable.
+        bool first(const Production&, std::size_t, IndexList&) const;
+
+        // Checks if two kernel lookahead lists are weakly compatible.
+        // Complexity: O(k^2), where k is the size of the kernel
+        static bool compatible(const std::vector<IndexList>&,
+            const std::vector<IndexList>&, std::size_t);
+    };
+}
+
+#endif
@@ -0,0 +1,99 @@
+/* created by Ghabriel Nunes <ghabriel.nunes@gmail.com> [2016] */
+
+#ifndef LRPARSER_HPP
+#define LRPARSER_HPP
+
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include "IndexList.hpp"
+#include "LRTable.hpp"
+#include "Parser.hpp"
+
+namespace parser {
+    /*
+     * Base class of the table-driven LR parsers. Subclasses compute the
+     * states and the lookaheads of the reductions; this class packs them
+     * into an LRTable and drives it with an integer state stack.
+     */
+    class LRParser : public Parser {
+    public:
+        using Parser::Symbol;
+        using Parser::TokenType;
+        using SymbolId = CFG::SymbolId;
+
+        LRParser(const CFG&);
+        ParseResults parse(const std::vector<Token>&) override;
+        bool canParse() const override;
+
+        // Same as above, but also builds the syntax tree of the input
+        // into a given tree, replacing its previous nodes.
+        ParseResults parse(const std::vector<Token>&, ParseTree&);
+
+        // Same as above, but the input is given as terminal ids of the CFG
+        // (see terminalIds()), which are mapped to columns without looking
+        // up their names.
+        ParseResults parse(const std::vector<SymbolId>&);
+        ParseResults parse(const std::vector<SymbolId>&, ParseTree&);
+
+        // Returns the number of states of the parse table.
+        // Complexity: O(1)
+        std::size_t numStates() const;
+
+    protected:
+        // The grammar the states refer to, i.e. the original one plus
+        // <S'> ::= <S> EOS as its last production (see augment()).
+        CFG augmented;
+
+        using State = LRTable::State;
+        LRTable table;
+        // Terminal column of each token type. Unknown types are mapped
+        // to an extra column, which is always an error.
+        std::unordered_map<TokenType, unsigned> columnByType;
+        // Terminal column of each symbol id of the original grammar, where
+        // non-terminals are unknown
+        std::vector<unsigned> columnById;
+        unsigned endOfSentence;
+        unsigned unknown;
+        // Length and non-terminal column of the left side of each
+        // production of the augmented grammar
+        std::vector<unsigned> lengths;
+        std::vector<unsigned> names;
+
+        // Fills the table from a collection of states. The lookaheads of
+        // a reducing item are given as ids of the augmented grammar by a
+        // function of (state number, item number). Conflicts are reported
+        // and make the parser unusable, unless they are kept in the table
+        // as CONFLICT entries.
+        void build(const std::vector<LR0State>&,
+            const std::function<const IndexList&(std::size_t, std::size_t)>&,
+            bool keepConflicts = false);
+
+        // Returns the column of a token, given either as a Token or as a
+        // terminal id.
+        unsigned column(const Token&) const;
+        unsigned column(SymbolId) const;
+
+        // Returns the type of the token at an index of the input, or the
+        // name of the end marker of the augmented grammar past its end.
+        template<typename T>
+        const TokenType& typeAt(const std::vector<T>& tokens, std::size_t index) const {
+            return (index < tokens.size()) ? typeOf(tokens[index])
+                                           : augmented.symbol(terminals[endOfSentence]);
+        }
+
+    private:
+        std::vector<State> stack;
+        std::vector<ParseNode*> nodes;
+        // Symbol id of each terminal column
+        std::vector<SymbolId> terminals;
+        bool conflict = false;
+
+        // Drives the table over tokens or terminal ids, building a tree
+        // if one is given.
+        template<typename T>
+        ParseResults run(const std::vector<T>&, ParseTree*);
+    };
+}
+
+#endif
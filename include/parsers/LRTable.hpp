@@ -0,0 +1,126 @@
+/* created by Ghabriel Nunes <ghabriel.nunes@gmail.com> [2016] */
+
+#ifndef LRTABLE_HPP
+#define LRTABLE_HPP
+
+#include <utility>
+#include <vector>
+#include "Parser.hpp"
+
+namespace parser {
+    struct AscendingAction {
+        Action action = Action::UNKNOWN;
+        std::size_t target;
+    };
+
+    /*
+     * A compressed LR parse table. Terminals and non-terminals are numbered
+     * densely and separately, starting from 0. Actions are encoded as
+     * integers (0 is an error) and each state may have a default reduction,
+     * used for every terminal it has no explicit action for. The remaining
+     * ACTION entries are packed into a single comb vector through row
+     * displacement: the entry of (state, terminal) lives at
+     * base[state] + terminal if check[] confirms it belongs to that state.
+     * GOTO entries are packed the same way, with one row per non-terminal
+     * and a default target per non-terminal.
+     *
+     * The table is built one state at a time (see addState) and must be
+     * compressed before it's used. Tables built with addAction may keep
+     * several actions in a cell, in which case its entry is a CONFLICT
+     * pointing to the list of actions (see conflicts()).
+     */
+    class LRTable {
+    public:
+        using State = unsigned;
+        using Entry = unsigned;
+        const static State none = -1;
+        const static Entry error = 0;
+
+        LRTable(std::size_t = 0, std::size_t = 0);
+
+        // Returns the number of states of this table.
+        std::size_t size() const;
+
+        // Starts the row of a new state, whose number is returned.
+        State addState();
+
+        // Sets the action of the last added state on a terminal. Returns
+        // false if it conflicts with a different action set before.
+        // Complexity: O(1)
+        bool setAction(unsigned, const AscendingAction&);
+
+        // Same as above, but keeps every distinct action of a cell instead
+        // of rejecting the new one.
+        void addAction(unsigned, const AscendingAction&);
+
+        // Sets the target state of the last added state on a non-terminal.
+        void setGoto(unsigned, State);
+
+        // Chooses the default reductions and packs the table.
+        // Complexity: O(n.k.w), where n is the number of rows, k is the
+        // number of explicit entries per row and w is the number of columns
+        void compress();
+
+        // Returns the encoded action of a state on a terminal.
+        Entry action(State state, unsigned terminal) const {
+            std::size_t index = actionBase[state] + terminal;
+            return (actionCheck[index] == state) ? actionValue[index] : defaultAction[state];
+        }
+
+        // Returns the state reached from a state through a non-terminal.
+        State go(State state, unsigned nonTerminal) const {
+            std::size_t index = gotoBase[nonTerminal] + state;
+            return (gotoCheck[index] == nonTerminal) ? gotoValue[index] : defaultGoto[nonTerminal];
+        }
+
+        // Returns the actions of a CONFLICT entry.
+        const std::vector<Entry>& conflicts(Entry entry) const {
+            return conflictLists[target(entry)];
+        }
+
+        // Decodes an action.
+        static Action kind(Entry entry) {
+            return kinds[entry & 7];
+        }
+
+        static std::size_t target(Entry entry) {
+            return entry >> 3;
+        }
+
+        static AscendingAction decode(Entry);
+
+    private:
+        using Row = std::vector<std::pair<unsigned, Entry>>;
+        static const Action kinds[8];
+        std::size_t numTerminals;
+        std::size_t numNonTerminals;
+
+        // Packed tables
+        std::vector<Entry> defaultAction;
+        std::vector<std::size_t> actionBase;
+        std::vector<State> actionCheck;
+        std::vector<Entry> actionValue;
+        std::vector<State> defaultGoto;
+        std::vector<std::size_t> gotoBase;
+        std::vector<unsigned> gotoCheck;
+        std::vector<State> gotoValue;
+        std::vector<std::vector<Entry>> conflictLists;
+
+        // Construction data, discarded by compress()
+        std::vector<Row> actionRows;
+        std::vector<Row> gotoRows;
+        std::vector<Entry> current;
+
+        static Entry encode(const AscendingAction&);
+
+        // Finds the entry of a terminal in the last added state, or
+        // creates an empty one.
+        Entry& cell(unsigned);
+
+        // Packs a list of rows into a comb vector.
+        static void pack(const std::vector<Row>&, std::size_t,
+            std::vector<std::size_t>&, std::vector<unsigned>&, std::vector<Entry>&);
+    };
+}
+
+#endif
@@ -2,21 +2,84 @@
 #ifndef PARSER_HPP
 #define PARSER_HPP
 
-#include <queue>
+#include <algorithm>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 #include "CFG.hpp"
+#include "Lexer.hpp"
 #include "utils.hpp"
 
-struct Token;
-
 struct ParseResults {
     bool accepted;
     std::size_t errorIndex;
     std::string errorMessage;
 };
 
+// A node of a concrete syntax tree. Leaves are tokens, referenced by
+// their index in the input; the other nodes are derivations through a
+// production of the CFG, whose token is the first one of their span
+// (or the following token, if they're empty).
+struct ParseNode {
+    const static std::size_t leaf = -1;
+    CFG::SymbolId symbol;
+    std::size_t production;
+    std::size_t token;
+    unsigned numChildren;
+    ParseNode** children;
+};
+
+// A syntax tree whose nodes are bump-allocated from an arena, which is
+// reused by every parse it's given to.
+class ParseTree {
+public:
+    // Returns the root of the tree, or nullptr if the last parse failed.
+    const ParseNode* root() const {
+        return rootNode;
+    }
+
+    // Releases every node.
+    // Complexity: O(1)
+    void clear() {
+        memory.clear();
+        rootNode = nullptr;
+    }
+
+    void setRoot(ParseNode* node) {
+        rootNode = node;
+    }
+
+    // Creates a node of a token.
+    // Complexity: O(1)
+    ParseNode* leaf(CFG::SymbolId symbol, std::size_t token) {
+        return create(symbol, ParseNode::leaf, token, 0);
+    }
+
+    // Creates a node of a production, whose children must be filled.
+    // Complexity: O(1)
+    ParseNode* node(CFG::SymbolId symbol, std::size_t production,
+        std::size_t token, unsigned numChildren) {
+
+        return create(symbol, production, token, numChildren);
+    }
+
+private:
+    utils::arena memory;
+    ParseNode* rootNode = nullptr;
+
+    ParseNode* create(CFG::SymbolId symbol, std::size_t production,
+        std::size_t token, unsigned numChildren) {
+
+        ParseNode* node = memory.allocate<ParseNode>();
+        *node = ParseNode{symbol, production, token, numChildren, nullptr};
+        if (numChildren > 0) {
+            node->children = memory.allocate<ParseNode*>(numChildren);
+        }
+        return node;
+    }
+};
+
 class Parser {
 public:
     using Symbol = std::string;
@@ -30,35 +93,96 @@ public:
     virtual ParseResults parse(const std::vector<Token>&) = 0;
     virtual bool canParse() const = 0;
 
+    // Returns the terminal ids of a sequence of tokens read by a lexer,
+    // for the parse overloads that take them. Each token type is looked
+    // up once; the ones that aren't terminals of the CFG are mapped to
+    // npos, which is always unexpected.
+    // Complexity: O(L + t), where t is the number of token types
+    std::vector<CFG::SymbolId> terminalIds(const std::vector<TokenSpan>& tokens,
+        const Lexer& lexer) const {
+
+        const CFG::SymbolId unmapped = CFG::npos - 1;
+        std::vector<CFG::SymbolId> idByType;
+        std::vector<CFG::SymbolId> result;
+        result.reserve(tokens.size());
+        for (auto& token : tokens) {
+            if (token.type >= idByType.size()) {
+                idByType.resize(token.type + 1, unmapped);
+            }
+            CFG::SymbolId& id = idByType[token.type];
+            if (id == unmapped) {
+                id = cfg.id(lexer.typeName(token.type));
+                if (id != CFG::npos && !cfg.isTerminal(id)) {
+                    id = CFG::npos;
+                }
+            }
+            result.push_back(id);
+        }
+        return result;
+    }
+
 protected:
+    // Returns the type of a token, given either as a Token or as a
+    // terminal id.
+    static const TokenType& typeOf(const Token& token) {
+        return token.type;
+    }
+
+    const TokenType& typeOf(CFG::SymbolId id) const {
+        static const TokenType unknown = "?";
+        return (id < cfg.numSymbols()) ? cfg.symbol(id) : unknown;
+    }
+
     ParseResults error(const std::vector<Token>& input,
         std::size_t index, const std::string& message) const {
 
+        return error(input, index, message, [&](std::size_t i) {
+            return input[i].content;
+        });
+    }
+
+    // Same as above, for an input of terminal ids, which is shown as
+    // the sequence of their names.
+    ParseResults error(const std::vector<CFG::SymbolId>& input,
+        std::size_t index, const std::string& message) const {
+
+        return error(input, index, message, [&](std::size_t i) {
+            return ((i > 0) ? " " : "") + typeOf(input[i]);
+        });
+    }
+
+private:
+    CFG cfg;
+
+    // Returns the error of a parse, showing the input through a function
+    // that returns the text of each of its tokens.
+    template<typename T, typename Text>
+    ParseResults error(const std::vector<T>& input, std::size_t index,
+        const std::string& message, const Text& text) const {
+
         ParseResults result;
         result.accepted = false;
         result.errorIndex = index;
         result.errorMessage = "Error: " + message + "\n";
         for (std::size_t i = 0; i < index; i++) {
-            result.errorMessage += input[i].content;
+            result.errorMessage += text(i);
         }
 
         if (index < input.size()) {
-            result.errorMessage += ("\033[1;31m" + input[index].content + "\033[0m");
+            result.errorMessage += ("\033[1;31m" + text(index) + "\033[0m");
             for (std::size_t i = index + 1; i < input.size(); i++) {
-                result.errorMessage += input[i].content;
+                result.errorMessage += text(i);
             }
         }
 
         return result;
     }
-
-private:
-    CFG cfg;
 };
 
 namespace parser {
     enum class Action {
         ACCEPT,
+        CONFLICT,
         GOTO,
         REDUCE,
         SHIFT,
@@ -69,7 +193,7 @@ namespace parser {
         std::size_t productionNumber;
         std::size_t position;
         mutable Action action = Action::UNKNOWN;
-        mutable std::size_t targetState;
+        mutable std::size_t targetState = 0;
     };
 
     inline bool operator==(const LR0Item& lhs, const LR0Item& rhs) {
@@ -81,31 +205,60 @@ namespace std {
     template<>
     struct hash<parser::LR0Item> {
         std::size_t operator()(const parser::LR0Item& item) const {
-            return item.productionNumber + item.position * 1e5;
+            std::size_t seed = std::hash<std::size_t>()(item.productionNumber);
+            return seed ^ (item.position + 0x9e3779b9 + (seed << 6) + (seed >> 2));
         }
     };
 }
 
 namespace parser {
+    inline bool operator<(const LR0Item& lhs, const LR0Item& rhs) {
+        return lhs.productionNumber < rhs.productionNumber
+            || (lhs.productionNumber == rhs.productionNumber && lhs.position < rhs.position);
+    }
+
+    // A kernel in canonical form, i.e. sorted and without duplicates.
+    using LR0Kernel = std::vector<LR0Item>;
+
+    struct LR0KernelHash {
+        std::size_t operator()(const LR0Kernel& kernel) const {
+            std::hash<LR0Item> hasher;
+            std::size_t seed = kernel.size();
+            for (auto& item : kernel) {
+                seed ^= hasher(item) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            }
+            return seed;
+        }
+    };
+
     struct LR0State {
-        std::unordered_set<LR0Item> kernel;
+        LR0Kernel kernel;
         std::vector<LR0Item> items;
     };
 
+    // An LR(0) state whose items carry lookahead sets. lookaheads[i]
+    // belongs to items[i], and the first items are the kernel ones.
+    struct LR1State : LR0State {
+        std::vector<IndexList> lookaheads;
+    };
+
     inline void expandState(LR0State& state, const CFG& cfg) {
-        for (auto& item : state.items) {
-            // TRACE(item.productionNumber);
+        // Items are appended during the iteration, so references
+        // to them can't be kept.
+        std::unordered_set<CFG::SymbolId> expanded;
+        for (std::size_t index = 0; index < state.items.size(); index++) {
+            const LR0Item& item = state.items[index];
             const Production& prod = cfg[item.productionNumber];
             if (item.position >= prod.size()) {
                 continue;
             }
 
-            auto symbol = prod[item.position];
-            if (cfg.isNonTerminal(symbol)) {
-                for (std::size_t i = 0; i < cfg.size(); i++) {
-                    const Production& production = cfg[i];
-                    if (production.getName() == symbol) {
-                        state.items.emplace_back(LR0Item{i, 0});
+            CFG::SymbolId symbol = prod.getProductIds()[item.position];
+            if (!cfg.isTerminal(symbol) && expanded.insert(symbol).second) {
+                for (std::size_t i : cfg.productionsOf(symbol)) {
+                    LR0Item newItem{i, 0};
+                    if (!std::binary_search(state.kernel.begin(), state.kernel.end(), newItem)) {
+                        state.items.push_back(newItem);
                     }
                 }
             }
@@ -131,40 +284,57 @@ namespace parser {
         ECHO("");
     }
 
+    // Returns a name that isn't used in a CFG, adding primes to a given
+    // one until it's not taken.
+    inline std::string freshName(const CFG& cfg, std::string name) {
+        while (cfg.id(name) != CFG::npos) {
+            name += "'";
+        }
+        return name;
+    }
+
+    // Returns a copy of a CFG with <S'> ::= <S> EOS as its last production,
+    // where <S> is its start symbol. The new symbols are added by id, since
+    // they may not be expressible in the representation of the CFG, and
+    // are renamed if their names are already used.
+    inline CFG augment(const CFG& cfg) {
+        CFG result = cfg;
+        CFG::SymbolId start = result.addSymbol(freshName(cfg, "<S'>"), false);
+        CFG::SymbolId end = result.addSymbol(freshName(cfg, "EOS"), true);
+        result.addProduction(start, {cfg[0].getNameId(), end});
+        return result;
+    }
+
     // Returns the LR(0) Collection of a CFG.
+    // Complexity: O(I), where I is the total number of items of the states
     inline std::vector<LR0State> LR0(const CFG& cfg) {
-        auto copy = cfg;
-        std::size_t last = copy.size();
-        copy << "<S'> ::= " + cfg[0].getName() + "'EOS'";
+        auto copy = augment(cfg);
+        std::size_t last = cfg.size();
 
         std::vector<LR0State> result;
+        // Index of the states by kernel
+        std::unordered_map<LR0Kernel, std::size_t, LR0KernelHash> stateByKernel;
 
         // Creates the initial state
         result.emplace_back();
-        result.back().kernel.emplace(LR0Item{last, 0});
-        result.back().items.push_back(*result.back().kernel.begin());
-
-        // Queue of not-yet-analyzed states
-        std::queue<std::size_t> pendingStates;
-        pendingStates.push(0);
-
-        while (!pendingStates.empty()) {
-            // Prevents the result vector from reallocating in the middle of
-            // this iteration (which would invalidate the state reference)
-            if (result.capacity() == result.size()) {
-                result.reserve(result.size() + 10);
-            }
-
-            // The current state being analyzed
-            LR0State& state = result[pendingStates.front()];
-            pendingStates.pop();
-
-            expandState(state, copy);
-            std::unordered_map<Parser::Symbol, std::unordered_set<LR0Item>> itemsPerTransition;
-            std::queue<LR0Item*> completedItems;
-
-            // Maps all possible next symbols to a group of LR0 Items
-            for (LR0Item& item : state.items) {
+        result.back().kernel.push_back(LR0Item{last, 0});
+        result.back().items = result.back().kernel;
+        stateByKernel.emplace(result.back().kernel, 0);
+
+        // States are analyzed in order of creation, so the not-yet-analyzed
+        // ones are the ones after current
+        for (std::size_t current = 0; current < result.size(); current++) {
+            expandState(result[current], copy);
+            auto& items = result[current].items;
+
+            // Groups the items by their next symbol, in order of appearance
+            std::unordered_map<CFG::SymbolId, std::size_t> groupBySymbol;
+            std::vector<CFG::SymbolId> symbols;
+            std::vector<LR0Kernel> kernels;
+            std::vector<std::size_t> groupOf(items.size());
+
+            for (std::size_t i = 0; i < items.size(); i++) {
+                LR0Item& item = items[i];
                 const Production& prod = copy[item.productionNumber];
                 if (item.position >= prod.size()) {
                     item.action = Action::REDUCE;
@@ -177,55 +347,45 @@ namespace parser {
                     continue;
                 }
 
-                // Pushes a copy of the item, with its position added by 1.
-                // These items will constitute the kernel of the target state.
-                LR0Item newItem{item.productionNumber, item.position + 1};
-                itemsPerTransition[prod[item.position]].insert(std::move(newItem));
-            }
-
-            // Uses the calculated map to find the target states of all items
-            // which have a SHIFT or GOTO action.
-            for (auto& pair : itemsPerTransition) {
-                auto& kernel = pair.second;
-                std::size_t targetState;
-                bool foundEqual = false;
-                // Checks if there's another state with the same kernel
-                for (std::size_t i = 0; i < result.size(); i++) {
-                    LR0State& st = result[i];
-                    if (st.kernel == kernel) {
-                        targetState = i;
-                        foundEqual = true;
-                        break;
-                    }
+                // The item with its position added by 1 belongs to the
+                // kernel of the target state
+                CFG::SymbolId symbol = prod.getProductIds()[item.position];
+                auto insertion = groupBySymbol.emplace(symbol, kernels.size());
+                if (insertion.second) {
+                    symbols.push_back(symbol);
+                    kernels.emplace_back();
                 }
+                groupOf[i] = insertion.first->second;
+                kernels[groupOf[i]].push_back(LR0Item{item.productionNumber, item.position + 1});
+            }
 
-                if (!foundEqual) {
-                    // If no matches were found, create a new state
-                    // and mark it as not-yet-analyzed
-                    targetState = result.size();
+            // Finds (or creates) the target state of each group
+            std::vector<std::size_t> targets(kernels.size());
+            for (std::size_t g = 0; g < kernels.size(); g++) {
+                auto& kernel = kernels[g];
+                std::sort(kernel.begin(), kernel.end());
+                kernel.erase(std::unique(kernel.begin(), kernel.end()), kernel.end());
+
+                auto insertion = stateByKernel.emplace(kernel, result.size());
+                targets[g] = insertion.first->second;
+                if (insertion.second) {
+                    // Note: this may reallocate result, invalidating items
                     result.emplace_back();
-                    result.back().kernel = kernel;
-                    result.back().items = std::vector<LR0Item>(kernel.begin(), kernel.end());
-                    pendingStates.push(targetState);
+                    result.back().items = kernel;
+                    result.back().kernel = std::move(kernel);
                 }
+            }
 
-                // Assigns the appropriate action type to each item
-                for (auto& item : kernel) {
-                    const Production& prod = copy[item.productionNumber];
-                    Action action = copy.isTerminal(prod[item.position - 1])
-                                  ? Action::SHIFT
-                                  : Action::GOTO;
-                    for (auto& i : state.items) {
-                        if (i.productionNumber == item.productionNumber
-                            && i.position + 1 == item.position) {
-
-                            i.action = action;
-                            i.targetState = targetState;
-                        }
-                    }
-                    item.action = action;
-                    item.targetState = targetState;
+            // Assigns the appropriate action type to each item
+            auto& state = result[current];
+            for (std::size_t i = 0; i < state.items.size(); i++) {
+                LR0Item& item = state.items[i];
+                if (item.action == Action::REDUCE || item.action == Action::ACCEPT) {
+                    continue;
                 }
+                std::size_t group = groupOf[i];
+                item.action = copy.isTerminal(symbols[group]) ? Action::SHIFT : Action::GOTO;
+                item.targetState = targets[group];
             }
         }
 
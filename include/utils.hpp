@@ -6,7 +6,9 @@
 #include <functional>
 #include <iostream>
 #include <unordered_map>
+#include "utils/arena.hpp"
 #include "utils/composite_iterator.hpp"
+#include "utils/digraph.hpp"
 #include "utils/bimap.hpp"
 #include "utils/reverse_iterator.hpp"
 
@@ -0,0 +1,65 @@
+/* created by Ghabriel Nunes <ghabriel.nunes@gmail.com> [2016] */
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <algorithm>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace utils {
+    // A bump allocator. Objects are carved out of large blocks and are
+    // only released all at once by clear(), which keeps the blocks for
+    // the next use, so they must be trivially destructible.
+    class arena {
+    public:
+        explicit arena(std::size_t blockSize = 1 << 16) : blockSize(blockSize) {}
+
+        // Returns uninitialized storage for count objects of type T.
+        // Complexity: O(1) amortized
+        template<typename T>
+        T* allocate(std::size_t count = 1) {
+            static_assert(std::is_trivially_destructible<T>::value,
+                "arena objects are never destroyed");
+            std::size_t size = sizeof(T) * count;
+            std::size_t offset = (used + alignof(T) - 1) & ~(alignof(T) - 1);
+            if (blocks.empty() || offset + size > blocks[current].size) {
+                grow(size);
+                offset = 0;
+            }
+            used = offset + size;
+            return reinterpret_cast<T*>(blocks[current].data.get() + offset);
+        }
+
+        // Releases every object, keeping the memory.
+        // Complexity: O(1)
+        void clear() {
+            current = 0;
+            used = 0;
+        }
+
+    private:
+        struct Block {
+            std::unique_ptr<char[]> data;
+            std::size_t size;
+        };
+
+        std::vector<Block> blocks;
+        std::size_t blockSize;
+        std::size_t current = 0;
+        std::size_t used = 0;
+
+        // Moves to the next block, creating it if it can't hold size bytes.
+        void grow(std::size_t size) {
+            std::size_t next = blocks.empty() ? 0 : current + 1;
+            if (next == blocks.size() || blocks[next].size < size) {
+                std::size_t length = std::max(blockSize, size);
+                blocks.insert(blocks.begin() + next,
+                    Block{std::unique_ptr<char[]>(new char[length]), length});
+            }
+            current = next;
+        }
+    };
+}
+
+#endif
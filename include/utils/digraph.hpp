@@ -0,0 +1,83 @@
+/* created by Ghabriel Nunes <ghabriel.nunes@gmail.com> [2016] */
+#ifndef DIGRAPH_HPP
+#define DIGRAPH_HPP
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace utils {
+    // Propagates sets along an inclusion graph, where b in includes[a]
+    // means that sets[b] is a subset of sets[a]. Uses the digraph
+    // algorithm of DeRemer and Pennello, so each strongly connected
+    // component is merged only once. Set must provide merge(const Set&).
+    // Complexity: O(es), where e is the number of edges
+    template<typename Set, typename Index>
+    void digraph(std::vector<Set>& sets,
+        const std::vector<std::vector<Index>>& includes) {
+
+        // Tarjan's algorithm, where each strongly connected component is
+        // merged into its root and then copied to the other members.
+        const std::size_t unvisited = 0;
+        const std::size_t done = -1;
+        std::size_t numNodes = sets.size();
+        std::vector<std::size_t> order(numNodes, unvisited);
+        std::vector<std::size_t> lowLink(numNodes);
+        std::vector<Index> component;
+        // Simulates the recursion, storing (node, next edge) pairs
+        std::vector<std::pair<Index, std::size_t>> calls;
+        std::size_t counter = 0;
+
+        auto visit = [&](Index node) {
+            counter++;
+            order[node] = counter;
+            lowLink[node] = counter;
+            component.push_back(node);
+            calls.emplace_back(node, 0);
+        };
+
+        for (Index root = 0; root < numNodes; root++) {
+            if (order[root] != unvisited) {
+                continue;
+            }
+
+            visit(root);
+            while (!calls.empty()) {
+                Index node = calls.back().first;
+                std::size_t& edge = calls.back().second;
+                if (edge < includes[node].size()) {
+                    Index next = includes[node][edge];
+                    edge++;
+                    if (order[next] == unvisited) {
+                        visit(next);
+                    } else {
+                        lowLink[node] = std::min(lowLink[node], order[next]);
+                        sets[node].merge(sets[next]);
+                    }
+                    continue;
+                }
+
+                calls.pop_back();
+                if (lowLink[node] == order[node]) {
+                    Index member;
+                    do {
+                        member = component.back();
+                        component.pop_back();
+                        order[member] = done;
+                        if (member != node) {
+                            sets[member] = sets[node];
+                        }
+                    } while (member != node);
+                }
+
+                if (!calls.empty()) {
+                    Index caller = calls.back().first;
+                    lowLink[caller] = std::min(lowLink[caller], lowLink[node]);
+                    sets[caller].merge(sets[node]);
+                }
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,83 @@
+/* created by Ghabriel Nunes <ghabriel.nunes@gmail.com> [2016] */
+
+#include <algorithm>
+#include <tuple>
+#include "ByteClasses.hpp"
+
+ByteClasses::ByteClasses() : population({256}) {
+    classes.fill(0);
+}
+
+void ByteClasses::refine(const std::unordered_map<char, long>& transitions) {
+    std::vector<Entry> entries;
+    entries.reserve(transitions.size());
+    for (auto& pair : transitions) {
+        unsigned char byte = pair.first;
+        entries.emplace_back(classes[byte], pair.second, byte);
+    }
+    refine(entries);
+}
+
+void ByteClasses::split(const std::bitset<256>& set) {
+    std::vector<Entry> entries;
+    for (unsigned byte = 0; byte < 256; byte++) {
+        if (set[byte]) {
+            entries.emplace_back(classes[byte], 0, byte);
+        }
+    }
+    refine(entries);
+}
+
+std::size_t ByteClasses::size() const {
+    return population.size();
+}
+
+const ByteClasses::ClassMap& ByteClasses::map() const {
+    return classes;
+}
+
+std::vector<char> ByteClasses::representatives() const {
+    std::vector<char> result(size());
+    std::vector<bool> found(size(), false);
+    for (unsigned byte = 0; byte < 256; byte++) {
+        unsigned char cls = classes[byte];
+        if (!found[cls]) {
+            found[cls] = true;
+            result[cls] = static_cast<char>(byte);
+        }
+    }
+    return result;
+}
+
+void ByteClasses::refine(std::vector<Entry>& entries) {
+    // Sorting groups the bytes by class and then by target
+    std::sort(entries.begin(), entries.end());
+
+    std::array<unsigned, 256> touched;
+    touched.fill(0);
+    for (auto& entry : entries) {
+        touched[std::get<0>(entry)]++;
+    }
+
+    unsigned newClass = 0;
+    for (std::size_t i = 0; i < entries.size(); i++) {
+        auto& entry = entries[i];
+        unsigned oldClass = std::get<0>(entry);
+        bool firstOfClass = (i == 0 || std::get<0>(entries[i - 1]) != oldClass);
+        bool firstOfGroup = firstOfClass
+                         || std::get<1>(entries[i - 1]) != std::get<1>(entry);
+        if (firstOfGroup) {
+            if (firstOfClass && touched[oldClass] == population[oldClass]) {
+                // Every byte of the class has a transition, so the first
+                // group keeps the old id (it would become empty otherwise).
+                newClass = oldClass;
+            } else {
+                newClass = population.size();
+                population.push_back(0);
+            }
+        }
+        population[oldClass]--;
+        population[newClass]++;
+        classes[std::get<2>(entry)] = newClass;
+    }
+}
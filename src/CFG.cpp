@@ -1,29 +1,62 @@
 /* created by Ghabriel Nunes <ghabriel.nunes@gmail.com> [2016] */
 
+#include <algorithm>
 #include <cassert>
+#include <tuple>
 #include <queue>
 #include "CFG.hpp"
 #include "representations/SimplifiedBNF.hpp"
 
+namespace {
+    const std::vector<std::size_t> noProductions;
+}
+
 std::shared_ptr<const CFGRepresentation> CFG::defaultRepresentation(new SimplifiedBNF());
+const CFG::SymbolId CFG::npos;
 
 CFG::CFG() : representation(defaultRepresentation) {}
 
-CFG& CFG::internalAdd(const Production& prod) {
+CFG& CFG::internalAdd(Production prod) {
+    prod.productIds.clear();
     for (const Symbol& symbol : prod.products) {
         if (isTerminal(symbol)) {
             terminals.insert(symbol);
         } else {
             nonTerminals.insert(symbol);
         }
+        prod.productIds.push_back(intern(symbol));
     }
     nonTerminals.insert(prod.name);
-    productionsBySymbol[prod.name].push_back(size());
+    prod.nameId = intern(prod.name);
+    return addInterned(std::move(prod));
+}
+
+CFG& CFG::addInterned(Production prod) {
+    productionsBySymbol[prod.nameId].push_back(size());
+    for (SymbolId symbol : prod.productIds) {
+        usagesBySymbol[symbol].push_back(size());
+    }
     productions.push_back(std::move(prod));
-    invalidate();
+    if (isAnalysisValid) {
+        update(size() - 1);
+    }
     return *this;
 }
 
+CFG::SymbolId CFG::intern(const Symbol& symbol) {
+    auto it = symbolIds.find(symbol);
+    if (it != symbolIds.end()) {
+        return it->second;
+    }
+    SymbolId id = symbolNames.size();
+    symbolIds.emplace(symbol, id);
+    symbolNames.push_back(symbol);
+    terminalById.push_back(isTerminal(symbol));
+    productionsBySymbol.emplace_back();
+    usagesBySymbol.emplace_back();
+    return id;
+}
+
 CFG& CFG::add(const Symbol& name, const BNF& rhs) {
     assert(isNonTerminal(name));
     auto parts = getRepresentation().decompose(name, rhs);
@@ -46,9 +79,43 @@ CFG& CFG::operator<<(const CFG::BNF& production) {
     return add(production);
 }
 
+CFG::SymbolId CFG::addSymbol(const Symbol& symbol, bool terminal) {
+    SymbolId id = this->id(symbol);
+    if (id != npos) {
+        assert(isTerminal(id) == terminal);
+        return id;
+    }
+    id = intern(symbol);
+    terminalById[id] = terminal;
+    if (terminal) {
+        terminals.insert(symbol);
+    } else {
+        nonTerminals.insert(symbol);
+    }
+    if (isAnalysisValid) {
+        grow();
+    }
+    return id;
+}
+
+CFG& CFG::addProduction(SymbolId name, const std::vector<SymbolId>& products) {
+    assert(!isTerminal(name));
+    Production prod(symbolNames[name]);
+    prod.nameId = name;
+    prod.productIds = products;
+    for (SymbolId id : products) {
+        prod.products.push_back(symbolNames[id]);
+    }
+    return addInterned(std::move(prod));
+}
+
 void CFG::clear() {
     productions.clear();
+    symbolNames.clear();
+    symbolIds.clear();
+    terminalById.clear();
     productionsBySymbol.clear();
+    usagesBySymbol.clear();
     nonTerminals.clear();
     terminals.clear();
     invalidate();
@@ -66,134 +133,139 @@ std::unordered_set<CFG::Symbol> CFG::getTerminals() const {
     return terminals;
 }
 
-bool CFG::isConsistent() const {
-    std::unordered_set<Symbol> prodNames;
-    prodNames.reserve(size());
-    for (auto& prod : productions) {
-        prodNames.insert(prod.name);
-    }
-    for (auto& prod : productions) {
-        for (auto& symbol : prod.products) {
-            if (!isTerminal(symbol) && prodNames.count(symbol) == 0) {
-                return false;
-            }
-        }
-    }
-    return true;
+std::size_t CFG::numSymbols() const {
+    return symbolNames.size();
 }
 
-void CFG::prepareFirst() const {
-    updateFirst();
+CFG::SymbolId CFG::id(const Symbol& symbol) const {
+    auto it = symbolIds.find(symbol);
+    return (it == symbolIds.end()) ? npos : it->second;
 }
 
-std::unordered_set<CFG::Symbol> CFG::first(const CFG::BNF& symbolSequence) const {
-    return groupedFirst(toSymbolSequence(symbolSequence));
+const CFG::Symbol& CFG::symbol(SymbolId id) const {
+    assert(id < numSymbols());
+    return symbolNames[id];
 }
 
-std::unordered_set<CFG::Symbol> CFG::follow(const Symbol& nonTerminal) const {
-    if (isTerminal(nonTerminal)) {
-        return {};
-    }
+bool CFG::isTerminal(SymbolId id) const {
+    assert(id < numSymbols());
+    return terminalById[id];
+}
 
-    if (isFollowValid) {
-        return followSet[nonTerminal];
+const std::vector<std::size_t>& CFG::productionsOf(SymbolId id) const {
+    assert(id < numSymbols());
+    return productionsBySymbol[id];
+}
+
+const IndexList& CFG::firstOf(SymbolId id) const {
+    assert(id < numSymbols());
+    analyze();
+    return firstSet[id];
+}
+
+const IndexList& CFG::followOf(SymbolId id) const {
+    assert(id < numSymbols());
+    analyze();
+    return followSet[id];
+}
+
+bool CFG::nullable(SymbolId id) const {
+    assert(id < numSymbols());
+    analyze();
+    return nullabilityBySymbol[id];
+}
+
+bool CFG::endable(SymbolId id) const {
+    if (isTerminal(id)) {
+        return false;
     }
+    analyze();
+    return followSet[id].isSet(endOfInput());
+}
 
-    const std::string END_OF_STRING = "$";
+CFG::SymbolId CFG::endOfInput() const {
+    analyze();
+    return capacity;
+}
 
-    followSet.clear();
-    followSet[productions[0].name].insert(END_OF_STRING);
-    std::unordered_map<Symbol, std::unordered_set<Symbol>> dependencies;
-    // Calculates all first-based follow sets, keeping track of dependencies
+bool CFG::isConsistent() const {
     for (auto& prod : productions) {
-        const std::string& name = prod.name;
-        std::size_t numProducts = prod.size();
-        for (std::size_t i = 0; i < numProducts; i++) {
-            const Symbol& symbol = prod[i];
-            if (!isTerminal(symbol)) {
-                bool isNullable = true;
-                for (std::size_t j = i + 1; j < numProducts; j++) {
-                    for (auto& s : groupedFirst({prod[j]})) {
-                        followSet[symbol].insert(s);
-                    }
-
-                    if (!groupedNullable({prod[j]})) {
-                        isNullable = false;
-                        break;
-                    }
-                }
-                if (isNullable && symbol != name) {
-                    dependencies[symbol].insert(name);
-                }
+        for (SymbolId id : prod.productIds) {
+            if (!isTerminal(id) && productionsBySymbol[id].empty()) {
+                return false;
             }
         }
     }
+    return true;
+}
 
-    // Solves all dependencies
-    bool stable = false;
-    while (!stable) {
-        stable = true;
-        for (auto& pair : dependencies) {
-            const Symbol& destination = pair.first;
-            std::size_t prevSize = followSet[destination].size();
-            for (const Symbol& origin : pair.second) {
-                for (const Symbol& symbol : followSet[origin]) {
-                    followSet[destination].insert(symbol);
-                }
-            }
-            if (followSet[destination].size() != prevSize) {
-                stable = false;
-            }
+void CFG::prepareFirst() const {
+    analyze();
+}
+
+std::unordered_set<CFG::Symbol> CFG::first(const CFG::BNF& symbolSequence) const {
+    std::unordered_set<Symbol> result;
+    for (const Symbol& symbol : toSymbolSequence(symbolSequence)) {
+        if (isTerminal(symbol)) {
+            result.insert(symbol);
+            break;
         }
-    }
 
-    endableNonTerminals.clear();
-    std::unordered_set<Symbol> nonTerminals = getNonTerminals();
-    // Removes END_OF_STRING of all follow sets and tags those who have it
-    // as endable non-terminals.
-    for (auto& symbol : nonTerminals) {
-        if (followSet[symbol].count(END_OF_STRING) > 0) {
-            endableNonTerminals.insert(symbol);
-            followSet[symbol].erase(END_OF_STRING);
+        SymbolId nonTerminal = id(symbol);
+        if (nonTerminal == npos) {
+            break;
         }
-    }
 
-    // Uncomment in case of emergency
-    // for (auto& pair : followSet) {
-    //     TRACE(pair.first);
-    //     TRACE_IT(pair.second);
-    //     ECHO("");
-    //     TRACE_IT(dependencies[pair.first]);
-    //     ECHO("###################################");
-    // }
-    // assert(false);
+        firstOf(nonTerminal).forEach([&](SymbolId s) {
+            result.insert(symbolNames[s]);
+        });
 
-    isFollowValid = true;
-    return followSet[nonTerminal];
+        if (!nullable(nonTerminal)) {
+            break;
+        }
+    }
+    return result;
+}
+
+std::unordered_set<CFG::Symbol> CFG::follow(const Symbol& nonTerminal) const {
+    SymbolId target = id(nonTerminal);
+    if (isTerminal(nonTerminal) || target == npos) {
+        return {};
+    }
+    return toSymbols(followOf(target));
 }
 
 bool CFG::nullable(const CFG::BNF& symbolSequence) const {
-    return groupedNullable(toSymbolSequence(symbolSequence));
+    return groupedNullable(toIds(toSymbolSequence(symbolSequence)));
+}
+
+std::size_t CFG::numDependencies() const {
+    analyze();
+    std::size_t count = 0;
+    for (SymbolId symbol = 0; symbol < numSymbols(); symbol++) {
+        count += firstUsers[symbol].size() + followUsers[symbol].size()
+              + followEdges[symbol].size();
+    }
+    return count;
 }
 
 bool CFG::endable(const Symbol& symbol) const {
-    if (isTerminal(symbol)) {
+    if (isTerminal(symbol) || id(symbol) == npos) {
         return false;
     }
-    follow(symbol);
-    return endableNonTerminals.count(symbol) > 0;
+    return endable(id(symbol));
 }
 
 std::unordered_set<CFG::Symbol> CFG::range(const CFG::BNF& symbolSequence) const {
-    std::vector<Symbol> symbols = toSymbolSequence(symbolSequence);
-    std::unordered_set<Symbol> result;
-    for (auto& symbol : symbols) {
-        std::unordered_set<std::size_t> visited;
+    std::vector<SymbolId> symbols = toIds(toSymbolSequence(symbolSequence));
+    IndexList result(numSymbols(), false);
+    for (SymbolId symbol : symbols) {
+        std::vector<bool> visited(size(), false);
         if (populateRangeBySymbol(symbol, result, visited, false)) {
             break;
         }
     }
-    return result;
+    return toSymbols(result);
 }
 
 bool CFG::isRecursive() const {
@@ -211,10 +283,11 @@ CFG::ReferenceType CFG::recursionType(const CFG::Symbol& symbol) const {
         return ReferenceType::NONE;
     }
 
-    for (std::size_t index : productionsBySymbol.at(symbol)) {
+    SymbolId target = id(symbol);
+    for (std::size_t index : productionsOf(symbol)) {
         const Production& prod = productions[index];
-        for (auto& s : prod.products) {
-            if (s == symbol) {
+        for (SymbolId s : prod.productIds) {
+            if (s == target) {
                 return ReferenceType::DIRECT;
             }
 
@@ -245,31 +318,28 @@ CFG::ReferenceType CFG::nonFactoringType(const CFG::Symbol& symbol) const {
     if (isTerminal(symbol)) {
         return ReferenceType::NONE;
     }
-    updateFirst();
-    std::unordered_set<Symbol> history;
-    std::unordered_set<Symbol> firstSets;
+    analyze();
+    std::unordered_set<SymbolId> history;
+    std::unordered_set<SymbolId> firstSets;
     bool indirect = false;
-    for (std::size_t index : productionsBySymbol.at(symbol)) {
+    for (std::size_t index : productionsOf(symbol)) {
         const Production& prod = productions[index];
         if (prod.size() == 0) {
             continue;
         }
 
-        if (isTerminal(prod[0])) {
-            if (history.count(prod[0]) > 0) {
+        SymbolId front = prod.productIds[0];
+        if (isTerminal(front)) {
+            if (history.count(front) > 0) {
                 return ReferenceType::DIRECT;
             }
-            history.insert(prod[0]);
+            history.insert(front);
         }
 
         if (!indirect) {
-            for (auto& s : prod.firstSet) {
-                if (firstSets.count(s) > 0) {
-                    indirect = true;
-                    break;
-                }
-                firstSets.insert(s);
-            }
+            prod.firstSet.forEach([&](SymbolId s) {
+                indirect = indirect || !firstSets.insert(s).second;
+            });
         }
     }
 
@@ -283,7 +353,7 @@ CFG CFG::withoutRecursion() const {
     for (auto& nonTerminal : nonTerminals) {
         ReferenceType recType = recursionType(nonTerminal);
         if (recType == ReferenceType::NONE) {
-            for (std::size_t index : productionsBySymbol.at(nonTerminal)) {
+            for (std::size_t index : productionsOf(nonTerminal)) {
                 const Production& prod = productions[index];
                 result << toReadableForm(prod);
             }
@@ -295,7 +365,7 @@ CFG CFG::withoutRecursion() const {
         }
 
         Symbol newNT = "<" + name(nonTerminal) + "'>";
-        for (std::size_t index : productionsBySymbol.at(nonTerminal)) {
+        for (std::size_t index : productionsOf(nonTerminal)) {
             const Production& prod = productions[index];
             std::size_t i;
             BNF newProd;
@@ -348,7 +418,7 @@ CFG::BNF CFG::debug() const {
     for (auto& symbol : getNonTerminals()) {
         content += symbol + " ::= ";
         bool ignore = true;
-        for (std::size_t index : productionsBySymbol.at(symbol)) {
+        for (std::size_t index : productionsOf(symbol)) {
             const Production& prod = productions[index];
             if (!ignore) {
                 content += "|";
@@ -376,6 +446,25 @@ std::vector<CFG::Symbol> CFG::toSymbolSequence(const CFG::BNF& input) const {
     return getRepresentation().toSymbolSequence(input);
 }
 
+std::vector<CFG::SymbolId> CFG::toIds(const std::vector<Symbol>& symbols) const {
+    std::vector<SymbolId> result;
+    result.reserve(symbols.size());
+    for (auto& symbol : symbols) {
+        result.push_back(id(symbol));
+    }
+    return result;
+}
+
+std::unordered_set<CFG::Symbol> CFG::toSymbols(const IndexList& ids) const {
+    std::unordered_set<Symbol> result;
+    ids.forEach([&](SymbolId id) {
+        if (id < numSymbols()) {
+            result.insert(symbolNames[id]);
+        }
+    });
+    return result;
+}
+
 bool CFG::isTerminal(const CFG::Symbol& symbol) const {
     return getRepresentation().isTerminal(symbol);
 }
@@ -392,227 +481,389 @@ std::string CFG::name(const CFG::Symbol& symbol) const {
     return getRepresentation().name(symbol);
 }
 
-void CFG::select(const CFG::Symbol& symbol,
-    const std::function<void(const Production&)>& callback) const {
-    if (!isTerminal(symbol)) {
-        for (auto index : productionsBySymbol.at(symbol)) {
-            callback(productions[index]);
-        }
-    }
+const std::vector<std::size_t>& CFG::productionsOf(const CFG::Symbol& symbol) const {
+    SymbolId index = id(symbol);
+    return (index == npos) ? noProductions : productionsBySymbol[index];
 }
 
-std::unordered_set<CFG::Symbol> CFG::groupedFirst(const std::vector<CFG::Symbol>& symbols) const {
-    std::unordered_set<Symbol> result;
+void CFG::analyze() const {
+    if (isAnalysisValid) {
+        return;
+    }
+
+    updateNullability();
     updateFirst();
-    for (const Symbol& symbol : symbols) {
-        if (isTerminal(symbol)) {
-            result.insert(symbol);
-            break;
+    updateFollow();
+    isAnalysisValid = true;
+}
+
+void CFG::update(std::size_t index) const {
+    grow();
+    productions[index].firstSet = IndexList(capacity, false);
+
+    // Productions whose edges may have changed
+    std::vector<std::size_t> changed = {index};
+    std::vector<SymbolId> worklist;
+    registerNullability(index, worklist);
+    while (!worklist.empty()) {
+        SymbolId symbol = worklist.back();
+        const auto& usages = usagesBySymbol[symbol];
+        changed.insert(changed.end(), usages.begin(), usages.end());
+        propagateNullability(worklist);
+    }
+
+    std::sort(changed.begin(), changed.end());
+    changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+
+    // Only the new values of each set are propagated
+    std::vector<Change> firstChanges;
+    std::vector<Change> followChanges;
+    auto insert = [](IndexList& set, SymbolId value) {
+        bool isNew = !set.isSet(value);
+        set.insert(value);
+        return isNew;
+    };
+
+    if (index == 0) {
+        followSet[productions[0].nameId].insert(capacity);
+        followChanges.emplace_back(productions[0].nameId, capacity);
+    }
+
+    for (std::size_t i : changed) {
+        link(i, &firstChanges, &followChanges);
+    }
+
+    while (!firstChanges.empty()) {
+        SymbolId symbol, value;
+        std::tie(symbol, value) = firstChanges.back();
+        firstChanges.pop_back();
+        for (std::size_t i : firstUsers[symbol]) {
+            const Production& prod = productions[i];
+            if (insert(prod.firstSet, value) && insert(firstSet[prod.nameId], value)) {
+                firstChanges.emplace_back(prod.nameId, value);
+            }
         }
-        select(symbol, [&result](const Production& prod) {
-            for (auto& s : prod.firstSet) {
-                result.insert(s);
+
+        for (SymbolId user : followUsers[symbol]) {
+            if (insert(followSet[user], value)) {
+                followChanges.emplace_back(user, value);
+            }
+        }
+    }
+
+    while (!followChanges.empty()) {
+        SymbolId symbol, value;
+        std::tie(symbol, value) = followChanges.back();
+        followChanges.pop_back();
+        for (SymbolId user : followEdges[symbol]) {
+            if (insert(followSet[user], value)) {
+                followChanges.emplace_back(user, value);
             }
-        });
-        if (!nullable(symbol)) {
-            break;
         }
     }
-    return result;
 }
 
-void CFG::updateFirst() const {
-    if (isFirstValid) {
+void CFG::grow() const {
+    std::size_t previous = firstSet.size();
+    std::size_t numSymbols = this->numSymbols();
+    if (numSymbols == previous) {
         return;
     }
 
-    // Stores information about all non-terminals for which a definitive
-    // conclusion about nullability has been found.
-    nullabilityBySymbol.clear();
-    std::unordered_map<Symbol, bool>& nullabilityTable = nullabilityBySymbol;
+    nullabilityBySymbol.resize(numSymbols, false);
+    nullableSince.resize(numSymbols, 0);
+    nullableOccurrences.resize(numSymbols);
+    firstUsers.resize(numSymbols);
+    followUsers.resize(numSymbols);
+    followEdges.resize(numSymbols);
 
-    // Avoids infinite loops in recursive grammars
-    using ProdSet = std::unordered_set<std::size_t>;
-    ProdSet visited;
+    if (numSymbols > capacity) {
+        // The end of the input is always stored after the last position
+        std::size_t oldCapacity = capacity;
+        capacity = capacityFor(numSymbols);
+        for (auto& set : firstSet) {
+            set.resize(capacity);
+        }
+        for (auto& prod : productions) {
+            prod.firstSet.resize(capacity);
+        }
+        for (SymbolId symbol = 0; symbol < previous; symbol++) {
+            IndexList& set = followSet[symbol];
+            if (!isTerminal(symbol)) {
+                bool endable = set.isSet(oldCapacity);
+                set.remove(oldCapacity);
+                set.resize(capacity + 1);
+                if (endable) {
+                    set.insert(capacity);
+                }
+            }
+        }
+    }
 
-    // Calculates nullability of all non-terminals
-    for (std::size_t counter = 0; counter < size(); counter++) {
-        updateNullability(counter, visited, nullabilityTable);
+    for (SymbolId symbol = previous; symbol < numSymbols; symbol++) {
+        firstSet.emplace_back(capacity, false);
+        if (isTerminal(symbol)) {
+            firstSet.back().insert(symbol);
+        }
+        std::size_t size = isTerminal(symbol) ? 0 : capacity + 1;
+        followSet.emplace_back(size, false);
     }
+}
 
-    std::unordered_map<Symbol, std::unordered_set<Symbol>> firstTable;
+std::size_t CFG::capacityFor(std::size_t numSymbols) {
+    return numSymbols + numSymbols / 2 + 64;
+}
 
-    auto push = [&firstTable](const Production& production, const Symbol& symbol) {
-        production.firstSet.insert(symbol);
-        firstTable[production.name].insert(symbol);
-    };
+void CFG::updateNullability() const {
+    // Leaves room for new symbols, which are handled by grow()
+    capacity = capacityFor(numSymbols());
+    nullabilityBySymbol.reserve(capacity);
+    nullableSince.reserve(capacity);
+    nullableOccurrences.reserve(capacity);
+    firstUsers.reserve(capacity);
+    followUsers.reserve(capacity);
+    followEdges.reserve(capacity);
+    firstSet.reserve(capacity);
+    followSet.reserve(capacity);
 
-    std::function<void(std::size_t, ProdSet&)> populate = [&](std::size_t index, ProdSet& visited) {
-        const Production& prod = productions[index];
-        if (visited.count(index) > 0) {
+    nullabilityBySymbol.assign(numSymbols(), false);
+    nullableSince.assign(numSymbols(), 0);
+    pendingSymbols.clear();
+    nullableOccurrences.assign(numSymbols(), {});
+
+    std::vector<SymbolId> worklist;
+    for (std::size_t i = 0; i < size(); i++) {
+        registerNullability(i, worklist);
+    }
+
+    while (!worklist.empty()) {
+        propagateNullability(worklist);
+    }
+}
+
+void CFG::registerNullability(std::size_t index, std::vector<SymbolId>& worklist) const {
+    const Production& prod = productions[index];
+    prod.nullable = false;
+    pendingSymbols.push_back(0);
+    for (SymbolId symbol : prod.productIds) {
+        if (isTerminal(symbol)) {
+            // Such production can never be nullable
             return;
         }
-        visited.insert(index);
-        // ECHO(toReadableForm(prod));
-        for (auto& symbol : prod.products) {
-            if (isTerminal(symbol)) {
-                // ECHOI(symbol + " -> FIRST(" + toReadableForm(prod) + ")", 1);
-                push(prod, symbol);
-                return;
-            }
+    }
+
+    for (SymbolId symbol : prod.productIds) {
+        if (!nullabilityBySymbol[symbol]) {
+            pendingSymbols[index]++;
+            nullableOccurrences[symbol].push_back(index);
+        }
+    }
+
+    if (pendingSymbols[index] == 0) {
+        markNullable(index, worklist);
+    }
+}
 
-            std::vector<std::size_t> indexList = productionsBySymbol.at(symbol);
-            // ECHO("[RECURSION]");
-            for (std::size_t i : indexList) {
-                // TRACE(i);
-                populate(i, visited);
+void CFG::propagateNullability(std::vector<SymbolId>& worklist) const {
+    SymbolId symbol = worklist.back();
+    worklist.pop_back();
+    for (std::size_t index : nullableOccurrences[symbol]) {
+        if (--pendingSymbols[index] == 0) {
+            markNullable(index, worklist);
+        }
+    }
+    nullableOccurrences[symbol].clear();
+}
+
+void CFG::markNullable(std::size_t index, std::vector<SymbolId>& worklist) const {
+    const Production& prod = productions[index];
+    prod.nullable = true;
+    if (!nullabilityBySymbol[prod.nameId]) {
+        nullabilityBySymbol[prod.nameId] = true;
+        nullableSince[prod.nameId] = ticks++;
+        worklist.push_back(prod.nameId);
+    }
+}
+
+void CFG::link(std::size_t index, std::vector<Change>* firstChanges,
+    std::vector<Change>* followChanges) const {
+
+    const Production& prod = productions[index];
+    SymbolId name = prod.nameId;
+    auto& products = prod.productIds;
+
+    // The edges that only depend on symbols which were already nullable
+    // when this production was last linked are known
+    if (linkedAt.size() <= index) {
+        linkedAt.resize(index + 1, npos);
+    }
+    std::size_t linked = linkedAt[index];
+    linkedAt[index] = ticks;
+    auto wasNullable = [&](SymbolId symbol) {
+        return linked != npos && nullabilityBySymbol[symbol]
+            && nullableSince[symbol] < linked;
+    };
+
+    bool known = (linked != npos);
+    for (SymbolId symbol : products) {
+        if (!known) {
+            firstUsers[symbol].push_back(index);
+            if (firstChanges) {
+                prod.firstSet.merge(firstSet[symbol], [&](SymbolId value) {
+                    if (!firstSet[name].isSet(value)) {
+                        firstSet[name].insert(value);
+                        firstChanges->emplace_back(name, value);
+                    }
+                });
             }
-            // ECHO("----");
+        }
 
-            for (auto& s : firstTable[symbol]) {
-                // ECHOI(s + " -> FIRST(" + toReadableForm(prod) + ")", 1);
-                push(prod, s);
+        if (!nullabilityBySymbol[symbol]) {
+            break;
+        }
+        known = known && wasNullable(symbol);
+    }
+
+    // Traverses the production backwards, keeping the symbols that
+    // may come right after the current one. The last knownTrailer
+    // symbols of the trailer were already linked to the current one.
+    std::vector<SymbolId> trailer;
+    std::size_t knownTrailer = 0;
+    bool nullableTrailer = true;
+    bool knownNullableTrailer = (linked != npos);
+    for (std::size_t i = products.size(); i > 0; i--) {
+        SymbolId symbol = products[i - 1];
+        if (!isTerminal(symbol)) {
+            auto push = [&](SymbolId value) {
+                followChanges->emplace_back(symbol, value);
+            };
+
+            for (std::size_t j = 0; j < trailer.size() - knownTrailer; j++) {
+                SymbolId next = trailer[j];
+                followUsers[next].push_back(symbol);
+                if (followChanges) {
+                    followSet[symbol].merge(firstSet[next], push);
+                }
             }
 
-            if (!nullabilityTable[symbol]) {
-                return;
+            if (nullableTrailer && !knownNullableTrailer && symbol != name) {
+                followEdges[name].push_back(symbol);
+                if (followChanges) {
+                    followSet[symbol].merge(followSet[name], push);
+                }
             }
         }
 
-        prod.nullable = true;
-    };
-
-    // The first iteration calculates the preliminary first set of all
-    // productions; the second ensures all incomplete first sets are fixed.
-    for (unsigned iter = 0; iter < 2; iter++) {
-        visited.clear();
-        for (std::size_t counter = 0; counter < size(); counter++) {
-            populate(counter, visited);
-        }
-        // ECHO("#############################################");
-    }
-
-    // ECHO("#######################################");
-    // ECHO("#######################################");
-    // for (auto& prod : productions) {
-    //     ECHO(toReadableForm(prod));
-    //     TRACE(prod.nullable);
-    //     TRACE_IT(prod.firstSet);
-    //     ECHO("");
-    // }
-    // for (auto& pair : productionsBySymbol) {
-    //     std::unordered_set<Symbol> result;
-    //     for (auto index : pair.second) {
-    //         auto& prod = productions[index];
-    //         for (auto& symbol : prod.firstSet) {
-    //             result.insert(symbol);
-    //         }
-    //     }
-    //     TRACE(pair.first);
-    //     TRACE(nullabilityTable[pair.first]);
-    //     TRACE_IT(result);
-    //     ECHO("-----");
-    // }
-
-    isFirstValid = true;
-    // assert(false);
-}
-
-bool CFG::groupedNullable(const std::vector<CFG::Symbol>& symbols) const {
-    updateFirst();
-    for (const Symbol& symbol : symbols) {
-        if (isTerminal(symbol) || !nullabilityBySymbol[symbol]) {
-            return false;
+        if (!nullabilityBySymbol[symbol]) {
+            trailer.clear();
+            nullableTrailer = false;
+        }
+        if (!wasNullable(symbol)) {
+            knownTrailer = 0;
+            knownNullableTrailer = false;
+        }
+        trailer.push_back(symbol);
+        if (linked != npos) {
+            knownTrailer++;
         }
     }
-    return true;
 }
 
-void CFG::updateNullability(std::size_t index, std::unordered_set<std::size_t>& visited,
-    std::unordered_map<Symbol, bool>& finishedNT) const {
-
-    // Just to improve readability.
-    const bool NULLABLE = true;
+void CFG::updateFirst() const {
+    std::size_t numSymbols = this->numSymbols();
+    firstSet.assign(numSymbols, IndexList(capacity, false));
+    firstUsers.assign(numSymbols, {});
+    followUsers.assign(numSymbols, {});
+    followEdges.assign(numSymbols, {});
+    linkedAt.assign(size(), npos);
+    for (SymbolId symbol = 0; symbol < numSymbols; symbol++) {
+        if (isTerminal(symbol)) {
+            firstSet[symbol].insert(symbol);
+        }
+    }
 
-    const Production& prod = productions[index];
-    if (visited.count(index) > 0 || finishedNT.count(prod.name) > 0) {
-        return;
+    for (std::size_t i = 0; i < size(); i++) {
+        link(i, nullptr, nullptr);
     }
-    visited.insert(index);
-    prod.firstSet.clear();
-    prod.nullable = false;
-    bool allNullable = true;
-    // Tries to find the answer without recursion
-    // ECHO("[START] " + toReadableForm(prod));
-    for (auto& symbol : prod.products) {
-        // TRACE_L("\tsymbol", symbol);
-        if (isTerminal(symbol)) {
-            // ECHO("\t[NOT NULL]");
-            return;
+
+    // includes[a] contains all symbols that a may start with
+    std::vector<std::vector<SymbolId>> includes(numSymbols);
+    for (SymbolId symbol = 0; symbol < numSymbols; symbol++) {
+        for (std::size_t i : firstUsers[symbol]) {
+            includes[productions[i].nameId].push_back(symbol);
         }
-        if (finishedNT.count(symbol) == 0) {
-            allNullable = false;
-        } else if (finishedNT[symbol] == !NULLABLE) {
-            // ECHO("\t[NOT NULL]");
-            return;
+    }
+
+    utils::digraph(firstSet, includes);
+
+    // Calculates the first set of each production
+    for (auto& prod : productions) {
+        prod.firstSet = IndexList(capacity, false);
+        for (SymbolId symbol : prod.productIds) {
+            prod.firstSet.merge(firstSet[symbol]);
+            if (!nullabilityBySymbol[symbol]) {
+                break;
+            }
         }
     }
+}
 
-    if (allNullable) {
-        finishedNT[prod.name] = NULLABLE;
-        prod.nullable = true;
-        // ECHO("\t[NULLABLE]");
-        return;
+void CFG::updateFollow() const {
+    followSet.clear();
+    for (SymbolId symbol = 0; symbol < numSymbols(); symbol++) {
+        // Terminals have no follow set
+        std::size_t size = isTerminal(symbol) ? 0 : capacity + 1;
+        followSet.emplace_back(size, false);
     }
 
-    // Recursion is necessary
-    // ECHO("\t[RECURSION MODE]");
-    for (auto& symbol : prod.products) {
-        if (finishedNT.count(symbol) > 0) {
-            // symbol is a nullable non-terminal (the previous loop would
-            // have returned if it wasn't).
-            continue;
-        }
+    if (size() > 0) {
+        followSet[productions[0].nameId].insert(capacity);
+    }
 
-        std::vector<std::size_t> indexList = productionsBySymbol.at(symbol);
-        for (std::size_t i : indexList) {
-            updateNullability(i, visited, finishedNT);
+    // includes[a] contains all non-terminals that a may end
+    std::vector<std::vector<SymbolId>> includes(numSymbols());
+    for (SymbolId symbol = 0; symbol < numSymbols(); symbol++) {
+        for (SymbolId user : followUsers[symbol]) {
+            followSet[user].merge(firstSet[symbol]);
         }
 
-        if (finishedNT.count(symbol) == 0) {
-            // If no production marked the symbol as nullable,
-            // then it isn't.
-            finishedNT[symbol] = !NULLABLE;
-            // ECHO("\t[CONCLUSION] " + symbol + " is NOT null");
-            return;
+        for (SymbolId user : followEdges[symbol]) {
+            includes[user].push_back(symbol);
         }
     }
 
-    // If we are here, the production is nullable.
-    finishedNT[prod.name] = NULLABLE;
-    prod.nullable = true;
-    // ECHO("\t[NULLABLE]");
+    utils::digraph(followSet, includes);
 }
 
-void CFG::populateRange(std::size_t index, std::unordered_set<CFG::Symbol>& result,
-    std::unordered_set<std::size_t>& visited) const {
+bool CFG::groupedNullable(const std::vector<SymbolId>& symbols) const {
+    analyze();
+    for (SymbolId symbol : symbols) {
+        if (symbol == npos || !nullabilityBySymbol[symbol]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void CFG::populateRange(std::size_t index, IndexList& result,
+    std::vector<bool>& visited) const {
 
-    if (visited.count(index) > 0) {
+    if (visited[index]) {
         return;
     }
-    visited.insert(index);
+    visited[index] = true;
     const Production& prod = productions[index];
-    for (auto& symbol : prod.products) {
+    for (SymbolId symbol : prod.productIds) {
         if (populateRangeBySymbol(symbol, result, visited)) {
             return;
         }
     }
 }
 
-bool CFG::populateRangeBySymbol(const Symbol& symbol, std::unordered_set<CFG::Symbol>& result,
-    std::unordered_set<std::size_t>& visited, bool push) const {
+bool CFG::populateRangeBySymbol(SymbolId symbol, IndexList& result,
+    std::vector<bool>& visited, bool push) const {
 
-    if (isTerminal(symbol)) {
+    if (symbol == npos || isTerminal(symbol)) {
         return true;
     }
 
@@ -620,7 +871,7 @@ bool CFG::populateRangeBySymbol(const Symbol& symbol, std::unordered_set<CFG::Sy
         result.insert(symbol);
     }
 
-    for (std::size_t index : productionsBySymbol.at(symbol)) {
+    for (std::size_t index : productionsBySymbol[symbol]) {
         populateRange(index, result, visited);
     }
 
@@ -628,8 +879,7 @@ bool CFG::populateRangeBySymbol(const Symbol& symbol, std::unordered_set<CFG::Sy
 }
 
 void CFG::invalidate() {
-    isFirstValid = false;
-    isFollowValid = false;
+    isAnalysisValid = false;
 }
 
 const CFGRepresentation& CFG::getRepresentation() const {
@@ -1,8 +1,101 @@
 /* created by Ghabriel Nunes <ghabriel.nunes@gmail.com> [2016] */
 
+#include <map>
 #include "DFA.hpp"
 #include "IndexList.hpp"
 
+namespace {
+    // A refinable partition of the range [0, n). Elements are marked one
+    // at a time and split() separates the marked elements of each block
+    // from the unmarked ones, in time proportional to the number of marks.
+    class Partition {
+    public:
+        explicit Partition(std::size_t size)
+          : elements(size), location(size), owner(size, 0) {
+            for (std::size_t i = 0; i < size; i++) {
+                elements[i] = i;
+                location[i] = i;
+            }
+            if (size > 0) {
+                first.push_back(0);
+                last.push_back(size);
+                marked.push_back(0);
+            }
+        }
+
+        std::size_t numBlocks() const {
+            return first.size();
+        }
+
+        std::size_t blockOf(std::size_t element) const {
+            return owner[element];
+        }
+
+        std::size_t size(std::size_t block) const {
+            return last[block] - first[block];
+        }
+
+        std::vector<std::size_t>::const_iterator begin(std::size_t block) const {
+            return elements.begin() + first[block];
+        }
+
+        std::vector<std::size_t>::const_iterator end(std::size_t block) const {
+            return elements.begin() + last[block];
+        }
+
+        // Moves an element to the marked region at the front of its block.
+        void mark(std::size_t element) {
+            std::size_t block = owner[element];
+            std::size_t position = location[element];
+            std::size_t boundary = first[block] + marked[block];
+            if (position < boundary) {
+                return;
+            }
+            if (marked[block] == 0) {
+                touched.push_back(block);
+            }
+            std::size_t other = elements[boundary];
+            elements[boundary] = element;
+            elements[position] = other;
+            location[element] = boundary;
+            location[other] = position;
+            marked[block]++;
+        }
+
+        // Splits all partially marked blocks, calling a callback with
+        // the old block and the new one, which holds the marked elements.
+        template<typename Callback>
+        void split(const Callback& callback) {
+            for (std::size_t block : touched) {
+                std::size_t count = marked[block];
+                marked[block] = 0;
+                if (count == size(block)) {
+                    continue;
+                }
+                std::size_t newBlock = first.size();
+                first.push_back(first[block]);
+                last.push_back(first[block] + count);
+                marked.push_back(0);
+                first[block] += count;
+                for (std::size_t i = first[newBlock]; i < last[newBlock]; i++) {
+                    owner[elements[i]] = newBlock;
+                }
+                callback(block, newBlock);
+            }
+            touched.clear();
+        }
+
+    private:
+        std::vector<std::size_t> elements;
+        std::vector<std::size_t> location;
+        std::vector<std::size_t> owner;
+        std::vector<std::size_t> first;
+        std::vector<std::size_t> last;
+        std::vector<std::size_t> marked;
+        std::vector<std::size_t> touched;
+    };
+}
+
 const std::string DFA::errorStateName = "__ERROR__";
 const std::string DFA::materializedErrorPrefix = "m__error";
 
@@ -24,6 +117,7 @@ State& DFA::initialState() {
 
 void DFA::initialState(const State& state) {
     initialStateIndex = states[state];
+    invalidate();
 }
 
 State& DFA::state() {
@@ -47,6 +141,7 @@ DFA& DFA::removeState(const State& state) {
             }
         }
         states.erase(index);
+        invalidate();
     }
     return *this;
 }
@@ -61,9 +156,20 @@ void DFA::reset() {
 }
 
 void DFA::read(const std::string& input) {
+    if (errorState) {
+        return;
+    }
+    const TransitionTable& frozen = compile();
+    TransitionTable::Index state = indexToTable.at(currentState);
     for (char c : input) {
-        read(c);
+        TransitionTable::Index next = frozen.next(state, c);
+        if (next == TransitionTable::dead) {
+            errorState = true;
+            break;
+        }
+        state = next;
     }
+    currentState = tableToIndex[state];
 }
 
 void DFA::read(char input) {
@@ -78,26 +184,67 @@ void DFA::read(char input) {
     }
 }
 
+const TransitionTable& DFA::compile() const {
+    if (isTableValid) {
+        return table;
+    }
+
+    tableToIndex.clear();
+    tableToIndex.reserve(size());
+    indexToTable.clear();
+    indexToTable.reserve(size());
+    for (auto& pair : states) {
+        indexToTable[pair.first] = tableToIndex.size();
+        tableToIndex.push_back(pair.first);
+    }
+
+    table = TransitionTable(size(), classes());
+    for (auto& pair : states) {
+        auto from = indexToTable[pair.first];
+        for (auto& transition : pair.second.transitions) {
+            table.addTransition(from, indexToTable[transition.second], transition.first);
+        }
+        if (pair.second.accepts) {
+            table.accept(from);
+        }
+    }
+    table.initialState(size() > 0 ? indexToTable[initialStateIndex] : TransitionTable::dead);
+    isTableValid = true;
+    return table;
+}
+
+bool DFA::run(const std::string& input) const {
+    return compile().matches(input);
+}
+
+std::vector<bool> DFA::matchAll(const std::vector<std::string>& inputs) const {
+    return compile().matchAll(inputs);
+}
+
 bool DFA::accepts() const {
     return !errorState && states[currentState].accepts;
 }
 
 DFA& DFA::addTransition(const State& from, const State& to, char input) {
     states[states[from]].transitions[input] = states[to];
+    invalidate();
     return *this;
 }
 
 DFA& DFA::removeTransition(const State& from, char input) {
     states[states[from]].transitions.erase(input);
+    invalidate();
     return *this;
 }
 
 std::unordered_set<char> DFA::alphabet() const {
-    std::unordered_set<char> result;
-    transitionTraversal([&](const Index&, const Index&, char c) {
-        result.insert(c);
-    });
-    return result;
+    updateClasses();
+    return sigma;
+}
+
+const ByteClasses& DFA::classes() const {
+    updateClasses();
+    return byteClasses;
 }
 
 std::unordered_set<State> DFA::finalStates() const {
@@ -124,37 +271,43 @@ DFA DFA::withoutUselessStates() const {
 
 DFA DFA::withoutEquivalentStates() {
     DFA result;
-    std::queue<IndexList> classes = getEquivalenceClasses();
+    auto classes = getEquivalenceClasses();
+    result.reserve(classes.size());
     std::unordered_map<Index, Index> stateMapping;
-    while (!classes.empty()) {
-        IndexList eqClass = classes.front();
-        classes.pop();
-
-        Index master = eqClass.extract();
-        State& masterState = states[master];
-        result << masterState;
-        Index trueIndex = result[masterState];
-        stateMapping[master] = trueIndex;
-
-        if (eqClass.isSet(initialStateIndex)) {
-            result.initialState(masterState);
-        }
-        eqClass.remove(master);
-
-        while (eqClass.count() > 0) {
-            Index index = eqClass.extract();
-            eqClass.remove(index);
+    std::vector<Index> masters;
+    masters.reserve(classes.size());
+    for (auto& eqClass : classes) {
+        // The initial state, if present, represents its class
+        Index master = eqClass.front();
+        Index trueIndex = result.size();
+        for (Index index : eqClass) {
+            if (index == initialStateIndex) {
+                master = index;
+                result.initialStateIndex = trueIndex;
+            }
             stateMapping[index] = trueIndex;
         }
-    }
 
-    transitionTraversal([&](const Index& from, const Index& to, char c) {
-        if (stateMapping.count(from) > 0 && stateMapping.count(to) > 0) {
-            result.addTransition(result[stateMapping[from]],
-                                 result[stateMapping[to]],
-                                 c);
+        const State& masterState = states[master];
+        result << masterState.getName();
+        result.states[trueIndex].accepts = masterState.accepts;
+        masters.push_back(master);
+    }
+
+    // Equivalent states have equivalent transitions, so it's
+    // enough to map the transitions of each master state.
+    for (std::size_t i = 0; i < masters.size(); i++) {
+        auto& source = states[masters[i]].transitions;
+        auto& transitions = result.states[i].transitions;
+        transitions.reserve(source.size());
+        for (auto& transition : source) {
+            auto it = stateMapping.find(transition.second);
+            if (it != stateMapping.end()) {
+                transitions[transition.first] = it->second;
+            }
         }
-    });
+    }
+    result.invalidate();
     result.reset();
     return result;
 }
@@ -196,6 +349,7 @@ DFA DFA::operator~() const {
     result.materializeErrorState();
     for (auto& pair : result.states) {
         pair.second.accepts = !pair.second.accepts;
+        result.invalidate();
         if (pair.second.getName() == errorStateName) {
             pair.second.name = materializedErrorPrefix + std::to_string(pair.first);
         }
@@ -244,6 +398,7 @@ DFA::Index& DFA::operator[](const State& state) {
 
 DFA& DFA::operator<<(const State& state) {
     states.insert(states.size(), state);
+    invalidate();
     if (states.size() == 1) {
         initialStateIndex = 0;
         reset();
@@ -295,6 +450,40 @@ void DFA::debug() const {
     }
 }
 
+void DFA::invalidate() {
+    isTableValid = false;
+    isClassesValid = false;
+}
+
+void DFA::updateClasses() const {
+    if (isClassesValid) {
+        return;
+    }
+
+    byteClasses = ByteClasses();
+    sigma.clear();
+    for (auto& pair : states) {
+        byteClasses.refine(pair.second.transitions);
+        for (auto& transition : pair.second.transitions) {
+            sigma.insert(transition.first);
+        }
+    }
+    isClassesValid = true;
+}
+
+std::vector<char> DFA::classRepresentatives() const {
+    updateClasses();
+    std::vector<char> result;
+    // All bytes of a class behave alike, so either all of them
+    // belong to the alphabet or none does.
+    for (char c : byteClasses.representatives()) {
+        if (sigma.count(c) > 0) {
+            result.push_back(c);
+        }
+    }
+    return result;
+}
+
 DFA::Index DFA::errorStateIndex() const {
     for (auto& pair : states) {
         auto& name = pair.second.getName();
@@ -332,68 +521,111 @@ IndexList DFA::getReachableStates() const {
     return setToList(reachable);
 }
 
-std::queue<IndexList> DFA::getEquivalenceClasses() {
+std::vector<std::vector<DFA::Index>> DFA::getEquivalenceClasses() {
     materializeErrorState(true);
-    auto sigma = alphabet();
-    auto finalSet = setToList(finalStates());
+    Index errorIndex = errorStateIndex();
+    auto symbols = classRepresentatives();
+    std::size_t numStates = size();
+    std::size_t numSymbols = symbols.size();
+
+    // Numbers the states densely
+    std::vector<Index> denseToIndex;
+    std::unordered_map<Index, std::size_t> indexToDense;
+    denseToIndex.reserve(numStates);
+    indexToDense.reserve(numStates);
+    for (auto& pair : states) {
+        indexToDense[pair.first] = denseToIndex.size();
+        denseToIndex.push_back(pair.first);
+    }
+
+    // Builds the inverse transitions, grouped by symbol and then by target.
+    // The predecessors of q through symbols[a] are stored in
+    // inverse[inverseStart[a * n + q], inverseStart[a * n + q + 1]).
+    std::vector<std::size_t> targets(numSymbols * numStates);
+    std::vector<std::size_t> inverseStart(numSymbols * numStates + 1, 0);
+    for (std::size_t q = 0; q < numStates; q++) {
+        auto& transitions = states[denseToIndex[q]].transitions;
+        for (std::size_t a = 0; a < numSymbols; a++) {
+            std::size_t target = indexToDense[transitions.at(symbols[a])];
+            targets[a * numStates + q] = target;
+            inverseStart[a * numStates + target + 1]++;
+        }
+    }
+    for (std::size_t i = 1; i < inverseStart.size(); i++) {
+        inverseStart[i] += inverseStart[i - 1];
+    }
+    std::vector<std::size_t> inverse(numSymbols * numStates);
+    std::vector<std::size_t> filled(inverseStart.begin(), inverseStart.end() - 1);
+    for (std::size_t a = 0; a < numSymbols; a++) {
+        for (std::size_t q = 0; q < numStates; q++) {
+            std::size_t slot = a * numStates + targets[a * numStates + q];
+            inverse[filled[slot]++] = q;
+        }
+    }
 
-    std::queue<IndexList> partitions;
-    std::queue<IndexList> helper;
-    std::unordered_set<IndexList> w;
+    Partition partition(numStates);
+    std::vector<std::pair<std::size_t, std::size_t>> worklist;
+    std::vector<bool> pending(numStates * numSymbols, false);
+    auto push = [&](std::size_t block, std::size_t symbol) {
+        pending[block * numSymbols + symbol] = true;
+        worklist.emplace_back(block, symbol);
+    };
+    auto smaller = [&](std::size_t first, std::size_t second) {
+        return partition.size(first) <= partition.size(second) ? first : second;
+    };
 
-    if (finalSet.count() > 0) {
-        partitions.push(finalSet);
+    for (std::size_t q = 0; q < numStates; q++) {
+        if (states[denseToIndex[q]].accepts) {
+            partition.mark(q);
+        }
     }
-    partitions.push(IndexList(size()) - finalSet);
-    w.reserve(size());
-    w.insert(finalSet);
+    partition.split([&](std::size_t block, std::size_t newBlock) {
+        std::size_t splitter = smaller(block, newBlock);
+        for (std::size_t a = 0; a < numSymbols; a++) {
+            push(splitter, a);
+        }
+    });
 
-    while (!w.empty()) {
-        IndexList list = *w.begin();
-        w.erase(list);
-        for (char c : sigma) {
-            auto predecessors = stateFilter(c, list);
-            while (!partitions.empty()) {
-                IndexList partition = partitions.front();
-                partitions.pop();
-                IndexList intersection = partition & predecessors;
-                IndexList difference = partition - predecessors;
-                auto intCount = intersection.count();
-                auto difCount = difference.count();
-                if (intCount != 0 && difCount != 0) {
-                    partitions.push(intersection);
-                    partitions.push(difference);
-                    if (w.count(partition) > 0) {
-                        w.erase(partition);
-                        w.insert(intersection);
-                        w.insert(difference);
-                    } else {
-                        if (intCount <= difCount) {
-                            w.insert(intersection);
-                        } else {
-                            w.insert(difference);
-                        }
-                    }
+    std::vector<std::size_t> splitter;
+    while (!worklist.empty()) {
+        std::size_t block = worklist.back().first;
+        std::size_t symbol = worklist.back().second;
+        worklist.pop_back();
+        pending[block * numSymbols + symbol] = false;
+
+        // The block may be split while its predecessors are marked
+        splitter.assign(partition.begin(block), partition.end(block));
+        for (std::size_t q : splitter) {
+            std::size_t slot = symbol * numStates + q;
+            for (std::size_t i = inverseStart[slot]; i < inverseStart[slot + 1]; i++) {
+                partition.mark(inverse[i]);
+            }
+        }
+
+        partition.split([&](std::size_t block, std::size_t newBlock) {
+            for (std::size_t a = 0; a < numSymbols; a++) {
+                if (pending[block * numSymbols + a]) {
+                    push(newBlock, a);
                 } else {
-                    helper.push(partition);
+                    push(smaller(block, newBlock), a);
                 }
             }
-            partitions.swap(helper);
-        }
+        });
     }
 
-    Index errorIndex = size() - 1;
-    while (!partitions.empty()) {
-        IndexList partition = partitions.front();
-        partitions.pop();
-        if (!partition.isSet(errorIndex)) {
-            helper.push(partition);
+    std::vector<std::vector<Index>> result;
+    std::size_t errorBlock = partition.blockOf(indexToDense[errorIndex]);
+    for (std::size_t block = 0; block < partition.numBlocks(); block++) {
+        if (block != errorBlock) {
+            result.emplace_back();
+            for (auto it = partition.begin(block); it != partition.end(block); it++) {
+                result.back().push_back(denseToIndex[*it]);
+            }
         }
     }
 
-    partitions.swap(helper);
     removeState(states[errorIndex]);
-    return partitions;
+    return result;
 }
 
 void DFA::materializeErrorState(bool forced) {
@@ -402,7 +634,7 @@ void DFA::materializeErrorState(bool forced) {
     }
     bool created = false;
     Index errorIndex = size();
-    std::unordered_set<char> sigma = alphabet();
+    const std::unordered_set<char> sigma = alphabet();
 
     auto materialize = [&]() {
         *this << errorStateName;
@@ -419,6 +651,7 @@ void DFA::materializeErrorState(bool forced) {
                     materialize();
                 }
                 transitions[c] = errorIndex;
+                invalidate();
             }
         }
     }
@@ -430,16 +663,6 @@ void DFA::materializeErrorState(bool forced) {
     }
 }
 
-IndexList DFA::stateFilter(char input, const IndexList& list) const {
-    IndexList result(size());
-    transitionTraversal([&](const Index& from, const Index& to, char c) {
-        if (c == input && list.isSet(to)) {
-            result.remove(from);
-        }
-    });
-    return ~result;
-}
-
 std::unordered_set<DFA::Index> DFA::bfs(const State& state) const {
     Index origin = states[state];
     std::unordered_set<Index> result;
@@ -462,30 +685,33 @@ std::unordered_set<DFA::Index> DFA::bfs(const State& state) const {
 DFA DFA::simplify(const IndexList& whitelist) const {
     DFA result;
     result.reserve(size());
+    std::unordered_map<Index, Index> mapping;
+    mapping.reserve(size());
     for (auto& pair : states) {
         if (whitelist.isSet(pair.first)) {
-            std::string newState = pair.second.getName();
-            result << newState;
-            if (pair.second.accepts) {
-                result.accept(newState);
-            }
+            Index newIndex = result.size();
+            result << pair.second.getName();
+            result.states[newIndex].accepts = pair.second.accepts;
+            mapping[pair.first] = newIndex;
             if (initialStateIndex == pair.first) {
-                result.initialStateIndex = result.states[pair.second];
+                result.initialStateIndex = newIndex;
             }
         }
     }
 
     for (auto& pair : states) {
         if (whitelist.isSet(pair.first)) {
-            auto& from = pair.second;
-            for (auto& transition : from.transitions) {
+            auto& transitions = result.states[mapping[pair.first]].transitions;
+            transitions.reserve(pair.second.transitions.size());
+            for (auto& transition : pair.second.transitions) {
                 auto& to = transition.second;
                 if (whitelist.isSet(to)) {
-                    result.addTransition(from, states[to], transition.first);
+                    transitions[transition.first] = mapping[to];
                 }
             }
         }
     }
+    result.invalidate();
     result.reset();
     return result;
 }
@@ -511,14 +737,17 @@ DFA DFA::productConstruction(DFA& other,
 
     materializeErrorState(true);
     other.materializeErrorState(true);
-    auto sigma1 = alphabet();
-    auto sigma2 = other.alphabet();
-    std::unordered_set<char> sigma;
-    for (char c : sigma1) {
-        sigma.insert(c);
-    }
-    for (char c : sigma2) {
-        sigma.insert(c);
+
+    // Bytes that share a class in both DFAs lead to the same pair of
+    // states, so each group of them only needs to be evaluated once.
+    std::map<std::pair<unsigned, unsigned>, std::vector<char>> groups;
+    auto& classes1 = classes();
+    auto& classes2 = other.classes();
+    for (unsigned byte = 0; byte < 256; byte++) {
+        char c = static_cast<char>(byte);
+        if (sigma.count(c) > 0 || other.sigma.count(c) > 0) {
+            groups[{classes1[c], classes2[c]}].push_back(c);
+        }
     }
     std::unordered_set<State> addedStates;
     std::vector<std::pair<Index, Index>> addedPairs;
@@ -546,15 +775,15 @@ DFA DFA::productConstruction(DFA& other,
     addedPairs.push_back(init);
     stateList.push(init);
     while (!stateList.empty()) {
-        auto& pair = stateList.front();
+        auto pair = stateList.front();
         stateList.pop();
         auto before = addedStates.size();
         auto state = format(pair);
         addedStates.insert(state);
         if (addedStates.size() != before) {
             result << state;
-            for (char c : sigma) {
-                auto newPair = apply(pair, c);
+            for (auto& group : groups) {
+                auto newPair = apply(pair, group.second.front());
                 addedPairs.push_back(newPair);
                 stateList.push(newPair);
             }
@@ -563,8 +792,11 @@ DFA DFA::productConstruction(DFA& other,
 
     for (auto& pair : addedPairs) {
         std::string state = format(pair);
-        for (char c : sigma) {
-            result.addTransition(state, format(apply(pair, c)), c);
+        for (auto& group : groups) {
+            std::string target = format(apply(pair, group.second.front()));
+            for (char c : group.second) {
+                result.addTransition(state, target, c);
+            }
         }
         if (heuristic(pair)) {
             result.accept(state);
@@ -1,8 +1,14 @@
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include "IndexList.hpp"
 
-IndexList::IndexList(ull size) : size(size) {
+IndexList::IndexList(ull size, bool filled) : size(size) {
+    if (!filled) {
+        lists.assign(((size + limit - 1) >> 6), 0);
+        return;
+    }
+
     if (size > 0) {
         ull numLists = ((size - 1) >> 6) + 1;
         for (ull i = 0; i < numLists - 1; i++) {
@@ -12,6 +18,20 @@ IndexList::IndexList(ull size) : size(size) {
     }
 }
 
+IndexList& IndexList::insert(IndexList::ull index) {
+    find(index) |= offset(index);
+    return *this;
+}
+
+IndexList& IndexList::resize(IndexList::ull newSize) {
+    lists.resize((newSize + limit - 1) >> 6, 0);
+    size = newSize;
+    if (size % limit != 0) {
+        lists.back() &= stream(size % limit);
+    }
+    return *this;
+}
+
 IndexList& IndexList::remove(IndexList::ull index) {
     find(index) &= ~offset(index);
     return *this;
@@ -30,6 +50,15 @@ bool IndexList::isSet(IndexList::ull index) const {
     return (find(index) & offset(index)) != 0;
 }
 
+bool IndexList::empty() const {
+    for (auto list : lists) {
+        if (list != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
 IndexList::ull IndexList::count() const {
     ull result = 0;
     for (auto copy : lists) {
@@ -41,6 +70,60 @@ IndexList::ull IndexList::count() const {
     return result;
 }
 
+bool IndexList::merge(const IndexList& other) {
+    ull changed = 0;
+    ull numLists = std::min(lists.size(), other.lists.size());
+    for (ull i = 0; i < numLists; i++) {
+        ull values = other.lists[i];
+        if (i + 1 == lists.size() && size % limit != 0) {
+            // Discards the values beyond the size of this list
+            values &= stream(size % limit);
+        }
+        changed |= values & ~lists[i];
+        lists[i] |= values;
+    }
+    return changed != 0;
+}
+
+bool IndexList::merge(const IndexList& other, const std::function<void(ull)>& callback) {
+    ull numLists = std::min(lists.size(), other.lists.size());
+    bool changed = false;
+    for (ull i = 0; i < numLists; i++) {
+        ull values = other.lists[i];
+        if (i + 1 == lists.size() && size % limit != 0) {
+            values &= stream(size % limit);
+        }
+        ull added = values & ~lists[i];
+        lists[i] |= added;
+        changed = changed || added != 0;
+        while (added != 0) {
+            callback((i << 6) + __builtin_ctzll(added));
+            added &= added - 1;
+        }
+    }
+    return changed;
+}
+
+bool IndexList::intersects(const IndexList& other) const {
+    ull numLists = std::min(lists.size(), other.lists.size());
+    for (ull i = 0; i < numLists; i++) {
+        if ((lists[i] & other.lists[i]) != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void IndexList::forEach(const std::function<void(ull)>& callback) const {
+    for (ull i = 0; i < lists.size(); i++) {
+        ull list = lists[i];
+        while (list != 0) {
+            callback((i << 6) + __builtin_ctzll(list));
+            list &= list - 1;
+        }
+    }
+}
+
 std::size_t IndexList::hash() const {
     return std::hash<ull>()(lists.back());
 }
@@ -1,4 +1,5 @@
 /* created by Ghabriel Nunes <ghabriel.nunes@gmail.com> [2016] */
+#include <algorithm>
 #include <cassert>
 #include <stack>
 #include <utility>
@@ -6,15 +7,37 @@
 #include "utils.hpp"
 
 void Lexer::ignore(char c) {
-    blacklist.insert(c);
+    blacklist.set(static_cast<unsigned char>(c));
 }
 
-void Lexer::addToken(const TokenType& tokenType, const Expression& expr) {
-    tokenTypes.insert(std::make_pair(tokenType, Regex(expr)));
+void Lexer::addToken(const TokenType& tokenType, const Expression& expr,
+    int priority) {
+
+    TokenId id = tokenId(tokenType);
+    for (auto& rule : tokenTypes) {
+        if (rule.id == id) {
+            return;
+        }
+    }
+    auto position = std::find_if(tokenTypes.begin(), tokenTypes.end(),
+        [priority](const TokenRule& rule) { return rule.priority < priority; });
+    tokenTypes.insert(position, TokenRule{id, priority, Regex(expr)});
+    isAutomatonValid = false;
 }
 
 void Lexer::removeToken(const TokenType& tokenType) {
-    tokenTypes.erase(tokenType);
+    // Unknown names aren't interned, since they have no rule anyway
+    auto type = typeIds.find(tokenType);
+    if (type == typeIds.end()) {
+        return;
+    }
+    for (auto it = tokenTypes.begin(); it != tokenTypes.end(); it++) {
+        if (it->id == type->second) {
+            tokenTypes.erase(it);
+            isAutomatonValid = false;
+            return;
+        }
+    }
 }
 
 bool Lexer::accepts() const {
@@ -26,128 +49,446 @@ const std::string& Lexer::getError() const {
 }
 
 std::vector<Token> Lexer::read(const std::string& input) {
-    errorMessage.clear();
     std::vector<Token> tokens;
+    for (auto& span : scan(input)) {
+        tokens.push_back(materialize(span, input));
+    }
+    return tokens;
+}
+
+std::vector<TokenSpan> Lexer::scan(const char* input, std::size_t length) {
+    compile();
+    errorMessage.clear();
+    std::vector<TokenSpan> tokens;
+    Failures failures(automaton.size());
     std::size_t i = 0;
-    std::size_t length = input.size();
     while (i < length) {
-        std::pair<std::size_t, Token> pair;
+        Cursor cursor = cursorAt(i);
         try {
-            pair = readNext(i, input);
+            advance(cursor, input, length, true, failures);
         } catch (std::string err) {
             errorMessage = err;
             return tokens;
         }
 
-        if (pair.second.type != "") {
-            tokens.push_back(std::move(pair.second));
+        if (cursor.token.length > 0) {
+            tokens.push_back(cursor.token);
         }
-        i = pair.first;
+        i = cursor.next;
     }
     return tokens;
 }
 
-std::pair<std::size_t, Token> Lexer::readNext(std::size_t startingIndex,
-    const std::string& input) {
+std::vector<TokenSpan> Lexer::scan(const std::string& input) {
+    return scan(input.data(), input.size());
+}
 
-    std::unordered_set<TokenType> notAborted;
-    for (auto& pair : tokenTypes) {
-        notAborted.insert(pair.first);
-        pair.second.reset();
+std::vector<TokenSpan> Lexer::scan(const MappedFile& file) {
+    if (!file.isOpen()) {
+        errorMessage = "Unable to read file";
+        return {};
     }
+    return scan(file.data(), file.size());
+}
 
-    std::unordered_map<TokenType, std::size_t> stateHistory;
+std::vector<TokenSpan> Lexer::scanParallel(const char* input, std::size_t length,
+    unsigned threads) {
+
+    std::size_t numChunks = std::min<std::size_t>(threads, length / minChunkSize);
+    if (numChunks <= 1) {
+        return scan(input, length);
+    }
+    compile();
+    errorMessage.clear();
 
-    std::size_t i = startingIndex;
-    std::size_t length = input.size();
-    bool foundRelevantSymbol = false;
-    auto pick = [&]() {
-        if (!foundRelevantSymbol) {
-            return std::make_pair(length, Token{"", ""});
+    std::vector<Chunk> chunks(numChunks);
+    std::size_t chunkSize = length / numChunks;
+    for (std::size_t i = 0; i < numChunks; i++) {
+        std::size_t begin = i * chunkSize;
+        if (i > 0) {
+            const char* from = input + begin;
+            const char* to = input + begin + chunkSize;
+            const char* it = std::find_if(from, to, [this](char c) {
+                return delimiters[static_cast<unsigned char>(c)];
+            });
+            begin = (it == to) ? begin : it - input;
+            chunks[i - 1].end = begin;
         }
+        chunks[i].begin = begin;
+    }
+    chunks.back().end = length;
+
+    std::vector<std::thread> workers;
+    for (auto& chunk : chunks) {
+        workers.emplace_back([&, this] {
+            scanChunk(chunk, input, length);
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    // Joins the chunks, scanning again from the right position
+    // the beginning of those whose guess was wrong
+    std::vector<TokenSpan> tokens;
+    Failures failures(automaton.size());
+    std::size_t i = 0;
+    for (auto& chunk : chunks) {
+        while (true) {
+            auto it = std::lower_bound(chunk.starts.begin(), chunk.starts.end(),
+                std::make_pair(i, std::size_t(0)));
+            if (it != chunk.starts.end() && it->first == i) {
+                tokens.insert(tokens.end(), chunk.tokens.begin() + it->second,
+                    chunk.tokens.end());
+                if (!chunk.error.empty()) {
+                    errorMessage = chunk.error;
+                    return tokens;
+                }
+                i = chunk.stop;
+                break;
+            }
+
+            if (i >= chunk.end) {
+                break;
+            }
+
+            Cursor cursor = cursorAt(i);
+            try {
+                advance(cursor, input, length, true, failures);
+            } catch (std::string err) {
+                errorMessage = err;
+                return tokens;
+            }
 
-        bool matched = false;
-        TokenType type;
-        std::size_t maxIndex;
-        for (auto& pair : stateHistory) {
-            if (!matched || pair.second > maxIndex) {
-                matched = true;
-                type = pair.first;
-                maxIndex = pair.second;
+            if (cursor.token.length > 0) {
+                tokens.push_back(cursor.token);
             }
+            i = cursor.next;
+        }
+    }
+    return tokens;
+}
+
+std::vector<TokenSpan> Lexer::scanParallel(const std::string& input, unsigned threads) {
+    return scanParallel(input.data(), input.size(), threads);
+}
+
+std::vector<TokenSpan> Lexer::scanParallel(const MappedFile& file, unsigned threads) {
+    if (!file.isOpen()) {
+        errorMessage = "Unable to read file";
+        return {};
+    }
+    return scanParallel(file.data(), file.size(), threads);
+}
+
+void Lexer::scanChunk(Chunk& chunk, const char* input, std::size_t length) const {
+    Failures failures(automaton.size());
+    std::size_t i = chunk.begin;
+    while (i < chunk.end) {
+        chunk.starts.emplace_back(i, chunk.tokens.size());
+        Cursor cursor = cursorAt(i);
+        try {
+            advance(cursor, input, length, true, failures);
+        } catch (std::string err) {
+            chunk.error = err;
+            break;
         }
 
-        if (!matched) {
-            throw error(input, startingIndex, i);
+        if (cursor.token.length > 0) {
+            chunk.tokens.push_back(cursor.token);
         }
+        i = cursor.next;
+    }
+    chunk.stop = i;
+}
 
-        std::string buffer;
-        for (i = startingIndex; i <= maxIndex; i++) {
-            if (blacklist.count(input[i]) == 0) {
-                buffer += input[i];
-            }
+Lexer::TokenId Lexer::tokenId(const TokenType& tokenType) {
+    auto it = typeIds.find(tokenType);
+    if (it != typeIds.end()) {
+        return it->second;
+    }
+    TokenId id = typeNames.size();
+    typeIds.emplace(tokenType, id);
+    typeNames.push_back(tokenType);
+    return id;
+}
+
+const Lexer::TokenType& Lexer::typeName(TokenId id) const {
+    return typeNames.at(id);
+}
+
+std::string Lexer::content(const TokenSpan& token, const char* input) const {
+    const char* begin = input + token.offset;
+    const char* end = begin + token.length;
+    std::string buffer;
+    buffer.reserve(token.length);
+    for (const char* it = begin; it != end; it++) {
+        if (!blacklist[static_cast<unsigned char>(*it)]) {
+            buffer += *it;
+        }
+    }
+    return buffer;
+}
+
+std::string Lexer::content(const TokenSpan& token, const std::string& input) const {
+    return content(token, input.data());
+}
+
+std::string Lexer::content(const TokenSpan& token, const MappedFile& file) const {
+    return content(token, file.data());
+}
+
+Token Lexer::materialize(const TokenSpan& token, const std::string& input) const {
+    return Token{typeName(token.type), content(token, input)};
+}
+
+void Lexer::compile() {
+    if (isAutomatonValid) {
+        return;
+    }
+    std::vector<const Regex*> regexes;
+    for (auto& rule : tokenTypes) {
+        regexes.push_back(&rule.regex);
+    }
+    automaton = Regex::combine(regexes);
+    isAutomatonValid = true;
+}
+
+Lexer::Cursor Lexer::cursorAt(std::size_t index) const {
+    Cursor cursor;
+    cursor.start = index;
+    cursor.position = index;
+    cursor.state = automaton.initialState();
+    cursor.type = TransitionTable::untagged;
+    cursor.firstIndex = 0;
+    cursor.maxIndex = 0;
+    cursor.foundRelevantSymbol = false;
+    return cursor;
+}
+
+bool Lexer::advance(Cursor& cursor, const char* input, std::size_t length,
+    bool atEnd, Failures& failures) const {
+
+    auto pick = [&](bool interrupted) {
+        if (!cursor.foundRelevantSymbol) {
+            cursor.next = length;
+            cursor.token = TokenSpan{0, 0, 0};
+            return true;
+        }
+
+        if (cursor.type == TransitionTable::untagged) {
+            throw error(input, cursor.start, std::min(cursor.position, length - 1));
+        }
+
+        if (cursor.trail.empty() && !interrupted) {
+            // Nothing before the next token can be reached again
+            failures.clear();
+        }
+        for (auto& pair : cursor.trail) {
+            failures.insert(pair.first, pair.second);
         }
+        cursor.trail.clear();
 
-        return std::make_pair(maxIndex + 1, Token{type, buffer});
+        std::size_t id = tokenTypes[cursor.type].id;
+        std::size_t first = cursor.firstIndex;
+        cursor.next = cursor.maxIndex + 1;
+        failures.discardBefore(cursor.next);
+        cursor.token = TokenSpan{id, first, cursor.next - first};
+        return true;
     };
+
+    std::size_t& i = cursor.position;
     while (i < length) {
-        char c = input[i];
-        if (foundRelevantSymbol) {
-            for (auto& regex : delimiters) {
-                if (regex.matches(c)) {
-                    return pick();
-                }
-            }
+        unsigned char c = input[i];
+        if (cursor.foundRelevantSymbol && delimiters[c]) {
+            return pick(false);
         }
 
-        if (blacklist.count(c) > 0) {
+        if (blacklist[c]) {
             i++;
             continue;
         }
 
-        foundRelevantSymbol = true;
-        auto it = notAborted.begin();
-        while (it != notAborted.end()) {
-            const TokenType& type = *it;
-            Regex& recognizer = tokenTypes.at(type);
-            recognizer.read(c);
-            if (recognizer.matches()) {
-                stateHistory[type] = i;
-            }
+        if (!cursor.foundRelevantSymbol) {
+            cursor.foundRelevantSymbol = true;
+            cursor.firstIndex = i;
+        }
 
-            if (recognizer.aborted()) {
-                it = notAborted.erase(it);
-            } else {
-                it++;
-            }
+        if (cursor.state != TransitionTable::dead) {
+            cursor.state = automaton.next(cursor.state, c);
+        }
+
+        if (cursor.state == TransitionTable::dead) {
+            throw error(input, cursor.start, i);
         }
 
-        if (notAborted.size() == 0) {
-            throw error(input, startingIndex, i);
+        if (automaton.accepts(cursor.state)) {
+            cursor.type = automaton.tag(cursor.state);
+            cursor.maxIndex = i;
+            cursor.trail.clear();
+        } else {
+            if (cursor.type != TransitionTable::untagged && failures.contains(i, cursor.state)) {
+                i++;
+                return pick(true);
+            }
+            cursor.trail.emplace_back(i, cursor.state);
         }
         i++;
     }
-    return pick();
+    return atEnd && pick(false);
+}
+
+Lexer::Failures::Failures(std::size_t numStates)
+    : rowSize((numStates + 63) / 64) {}
+
+void Lexer::Failures::insert(std::size_t position, TransitionTable::Index state) {
+    if (numRows == 0) {
+        base = position;
+    }
+    assert(position >= base);
+    if (position - base >= numRows) {
+        numRows = position - base + 1;
+        bits.resize(numRows * rowSize, 0);
+    }
+    bits[(position - base) * rowSize + state / 64] |= 1ull << (state % 64);
+}
+
+void Lexer::Failures::discardBefore(std::size_t position) {
+    // The rows are only moved once at least half of them are dead,
+    // which pays for moving the others
+    if (position > base && 2 * (position - base) >= numRows) {
+        erase(std::min(position - base, numRows));
+        base = position;
+    }
+}
+
+void Lexer::Failures::rebase(std::size_t position) {
+    if (position > base) {
+        erase(std::min(position - base, numRows));
+        base = position;
+    }
+    base -= position;
+}
+
+void Lexer::Failures::clear() {
+    bits.clear();
+    numRows = 0;
+}
+
+void Lexer::Failures::erase(std::size_t rows) {
+    bits.erase(bits.begin(), bits.begin() + rows * rowSize);
+    numRows -= rows;
 }
 
 void Lexer::addDelimiters(const std::initializer_list<char>& list) {
     for (char c : list) {
-        delimiters.push_back(Regex("\\" + std::string(1, c)));
+        delimiters.set(static_cast<unsigned char>(c));
     }
 }
 
 void Lexer::addDelimiters(const std::string& expr) {
-    delimiters.push_back(Regex(expr));
+    // Only single characters can act as delimiters
+    Regex regex(expr);
+    for (unsigned byte = 0; byte < 256; byte++) {
+        if (regex.matches(static_cast<char>(byte))) {
+            delimiters.set(byte);
+        }
+    }
 }
 
-std::string Lexer::error(const std::string& input, std::size_t from,
+std::string Lexer::error(const char* input, std::size_t from,
     std::size_t to) const {
 
     std::string buffer;
     for (std::size_t i = from; i <= to; i++) {
-        if (blacklist.count(input[i]) == 0) {
+        if (!blacklist[static_cast<unsigned char>(input[i])]) {
             buffer += input[i];
         }
     }
     return "Unknown symbol '" + buffer + "'";
 }
+
+Lexer::Stream::Stream(Lexer& lexer, const Callback& callback)
+    : lexer(lexer), callback(callback) {
+    lexer.compile();
+    cursor = lexer.cursorAt(0);
+    failures = Failures(lexer.automaton.size());
+}
+
+void Lexer::Stream::feed(const char* chunk, std::size_t length) {
+    if (!accepts()) {
+        return;
+    }
+    buffer.append(chunk, length);
+    run(false);
+}
+
+void Lexer::Stream::feed(const std::string& chunk) {
+    feed(chunk.data(), chunk.size());
+}
+
+void Lexer::Stream::feed(std::istream& stream, std::size_t chunkSize) {
+    std::vector<char> chunk(chunkSize);
+    while (stream.read(chunk.data(), chunkSize) || stream.gcount() > 0) {
+        feed(chunk.data(), stream.gcount());
+    }
+}
+
+void Lexer::Stream::finish() {
+    if (!accepts()) {
+        return;
+    }
+    run(true);
+    bufferOffset += buffer.size();
+    buffer.clear();
+    failures.clear();
+    cursor = lexer.cursorAt(0);
+}
+
+bool Lexer::Stream::accepts() const {
+    return errorMessage.empty();
+}
+
+const std::string& Lexer::Stream::getError() const {
+    return errorMessage;
+}
+
+void Lexer::Stream::run(bool atEnd) {
+    const char* input = buffer.data();
+    std::size_t length = buffer.size();
+    try {
+        while (cursor.position < length || (atEnd && cursor.start < length)) {
+            if (!lexer.advance(cursor, input, length, atEnd, failures)) {
+                break;
+            }
+
+            TokenSpan token = cursor.token;
+            if (token.length > 0) {
+                std::string content = lexer.content(token, input);
+                token.offset += bufferOffset;
+                callback(token, content);
+            }
+            cursor = lexer.cursorAt(cursor.next);
+        }
+    } catch (std::string err) {
+        errorMessage = err;
+        return;
+    }
+
+    // Drops the bytes that can no longer be part of a token
+    std::size_t consumed = cursor.start;
+    if (consumed > 0) {
+        buffer.erase(0, consumed);
+        bufferOffset += consumed;
+        cursor.position -= consumed;
+        cursor.firstIndex -= std::min(cursor.firstIndex, consumed);
+        cursor.maxIndex -= std::min(cursor.maxIndex, consumed);
+        cursor.start = 0;
+
+        // Failures are relative to the buffer too
+        for (auto& pair : cursor.trail) {
+            pair.first -= consumed;
+        }
+        failures.rebase(consumed);
+    }
+}
@@ -0,0 +1,76 @@
+/* created by Ghabriel Nunes <ghabriel.nunes@gmail.com> [2016] */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+#include "MappedFile.hpp"
+
+MappedFile::MappedFile(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) == 0) {
+        length = info.st_size;
+        if (length == 0) {
+            // Empty files can't be mapped, but are still valid
+            opened = true;
+        } else {
+            void* address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (address != MAP_FAILED) {
+                madvise(address, length, MADV_SEQUENTIAL);
+                memory = static_cast<const char*>(address);
+                opened = true;
+            } else {
+                length = 0;
+            }
+        }
+    }
+    close(fd);
+}
+
+MappedFile::MappedFile(MappedFile&& other)
+    : memory(other.memory), length(other.length), opened(other.opened) {
+    other.memory = nullptr;
+    other.length = 0;
+    other.opened = false;
+}
+
+MappedFile::~MappedFile() {
+    unmap();
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) {
+    if (this != &other) {
+        unmap();
+        std::swap(memory, other.memory);
+        std::swap(length, other.length);
+        std::swap(opened, other.opened);
+    }
+    return *this;
+}
+
+bool MappedFile::isOpen() const {
+    return opened;
+}
+
+const char* MappedFile::data() const {
+    return memory;
+}
+
+std::size_t MappedFile::size() const {
+    return length;
+}
+
+void MappedFile::unmap() {
+    if (memory) {
+        munmap(const_cast<char*>(memory), length);
+    }
+    memory = nullptr;
+    length = 0;
+    opened = false;
+}
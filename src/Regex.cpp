@@ -1,7 +1,6 @@
 /* created by Ghabriel Nunes <ghabriel.nunes@gmail.com> [2016] */
 #include <algorithm>
 #include <cassert>
-#include <queue>
 #include <stack>
 #include "Regex.hpp"
 #include "utils.hpp"
@@ -10,10 +9,11 @@ const std::string Regex::PATTERN_OR = "[|";
 const std::string Regex::PATTERN_CONTEXT_START = "[(";
 const std::string Regex::PATTERN_CONTEXT_END = "[)";
 const std::string Regex::PATTERN_WILDCARD = "[.";
+const long Regex::LazyCache::unknown;
 
 Regex::Regex() {}
 
-Regex::Regex(const std::string& expr) : expression(expr) {
+Regex::Regex(const std::string& expr, Mode mode) : expression(expr), mode(mode) {
     bool escape = false;
     std::size_t i = 0;
     std::size_t length = expr.size();
@@ -288,6 +288,20 @@ void Regex::build(std::deque<Regex::Composition>& tokens) {
         i++;
     }
 
+    for (auto& state : stateList) {
+        for (auto& pair : state.transitions) {
+            state.compiled.emplace_back(compilePattern(pair.first), pair.second);
+            byteClasses.split(state.compiled.back().first);
+        }
+    }
+
+    buildClosures();
+    buildTargets();
+    if (mode == Mode::DFA) {
+        table = powerset();
+    } else if (mode == Mode::LAZY) {
+        flush();
+    }
     reset();
 
     // for (i = 0; i < tokens.size(); i++) {
@@ -309,15 +323,38 @@ void Regex::build(std::deque<Regex::Composition>& tokens) {
 }
 
 void Regex::read(char c) {
-    std::unordered_set<std::size_t> newStates;
-    for (std::size_t index : currentStates) {
-        std::size_t newIndex = stateList[index].read(c);
-        if (newIndex < INT_MAX) {
-            newStates.insert(newIndex);
+    if (mode == Mode::DFA) {
+        if (dfaState != TransitionTable::dead) {
+            dfaState = table.next(dfaState, c);
         }
+        return;
     }
-    expandSpontaneous(newStates);
-    currentStates = std::move(newStates);
+
+    if (mode == Mode::LAZY) {
+        lazyRead(c);
+        return;
+    }
+
+    const std::size_t numClasses = byteClasses.size();
+    const std::size_t column = byteClasses[c];
+    const Word* masks = closureMasks.data();
+    Word* next = nextStates.data();
+    std::fill(nextStates.begin(), nextStates.end(), 0);
+    for (std::size_t w = 0; w < numWords; w++) {
+        Word word = currentStates[w];
+        while (word) {
+            std::size_t state = w * wordSize + __builtin_ctzll(word);
+            word &= word - 1;
+            std::size_t target = nfaTargets[state * numClasses + column];
+            if (target != INT_MAX) {
+                const Word* mask = masks + target * numWords;
+                for (std::size_t i = 0; i < numWords; i++) {
+                    next[i] |= mask[i];
+                }
+            }
+        }
+    }
+    currentStates.swap(nextStates);
 }
 
 bool Regex::matches(char c) {
@@ -325,7 +362,22 @@ bool Regex::matches(char c) {
 }
 
 bool Regex::matches(const std::string& input) {
+    if (mode == Mode::DFA) {
+        dfaState = table.run(input);
+        return matches();
+    }
+
     reset();
+    if (mode == Mode::LAZY) {
+        for (char c : input) {
+            if (dfaState == TransitionTable::dead) {
+                break;
+            }
+            lazyRead(c);
+        }
+        return matches();
+    }
+
     for (char c : input) {
         read(c);
     }
@@ -333,35 +385,293 @@ bool Regex::matches(const std::string& input) {
 }
 
 bool Regex::matches() const {
-    return currentStates.count(acceptingState) > 0;
+    if (mode == Mode::DFA) {
+        return table.accepts(dfaState);
+    }
+    if (mode == Mode::LAZY) {
+        return dfaState != TransitionTable::dead && cache.accepting[dfaState];
+    }
+    return !currentStates.empty() && isSet(currentStates.data(), acceptingState);
 }
 
 bool Regex::aborted() const {
-    return currentStates.size() == 0;
+    if (mode != Mode::NFA) {
+        return dfaState == TransitionTable::dead;
+    }
+    return std::all_of(currentStates.begin(), currentStates.end(),
+        [](Word word) { return word == 0; });
 }
 
 void Regex::reset() {
-    currentStates.clear();
-    currentStates.insert(0);
-    expandSpontaneous(currentStates);
+    if (mode == Mode::DFA) {
+        dfaState = table.initialState();
+        return;
+    }
+    if (mode == Mode::LAZY) {
+        dfaState = 0;
+        return;
+    }
+    if (stateList.empty()) {
+        return;
+    }
+    std::copy_n(closureMasks.begin(), numWords, currentStates.begin());
 }
 
-void Regex::expandSpontaneous(std::unordered_set<std::size_t>& states) const {
-    std::queue<std::size_t> queue;
-    for (auto& state : states) {
-        queue.push(state);
+DFA Regex::toDFA() const {
+    TransitionTable dfaTable = (mode == Mode::DFA) ? table : powerset();
+    auto name = [](std::size_t index) {
+        return "q" + std::to_string(index);
+    };
+
+    DFA result;
+    result.reserve(dfaTable.size());
+    for (std::size_t i = 0; i < dfaTable.size(); i++) {
+        result << name(i);
+        if (dfaTable.accepts(i)) {
+            result.accept(name(i));
+        }
     }
 
-    while (!queue.empty()) {
-        std::size_t state = queue.front();
-        queue.pop();
-        for (std::size_t index : stateList[state].spontaneous) {
-            if (states.count(index) == 0) {
-                states.insert(index);
-                queue.push(index);
+    for (std::size_t i = 0; i < dfaTable.size(); i++) {
+        for (unsigned byte = 0; byte < 256; byte++) {
+            char c = static_cast<char>(byte);
+            auto target = dfaTable.next(i, c);
+            if (target != TransitionTable::dead) {
+                result.addTransition(name(i), name(target), c);
             }
         }
     }
+    result.reset();
+    return result;
+}
+
+void Regex::setCacheLimit(std::size_t limit) {
+    // The initial state and the one being left must fit
+    cache.limit = std::max<std::size_t>(limit, 2);
+}
+
+void Regex::buildClosures() {
+    std::size_t numStates = stateList.size();
+    numWords = (numStates + wordSize - 1) / wordSize;
+    closures.assign(numStates, {});
+    closureMasks.assign(numStates * numWords, 0);
+    currentStates.assign(numWords, 0);
+    nextStates.assign(numWords, 0);
+
+    std::vector<std::size_t> stack;
+    for (std::size_t i = 0; i < numStates; i++) {
+        Word* mask = closureMasks.data() + i * numWords;
+        auto& closure = closures[i];
+        mask[i / wordSize] |= Word(1) << (i % wordSize);
+        closure.push_back(i);
+        stack.push_back(i);
+        while (!stack.empty()) {
+            std::size_t state = stack.back();
+            stack.pop_back();
+            for (std::size_t index : stateList[state].spontaneous) {
+                if (!isSet(mask, index)) {
+                    mask[index / wordSize] |= Word(1) << (index % wordSize);
+                    closure.push_back(index);
+                    stack.push_back(index);
+                }
+            }
+        }
+        std::sort(closure.begin(), closure.end());
+    }
+}
+
+void Regex::buildTargets() {
+    auto symbols = byteClasses.representatives();
+    std::size_t numClasses = symbols.size();
+    nfaTargets.assign(stateList.size() * numClasses, INT_MAX);
+    for (std::size_t i = 0; i < stateList.size(); i++) {
+        for (std::size_t a = 0; a < numClasses; a++) {
+            nfaTargets[i * numClasses + a] = stateList[i].read(symbols[a]);
+        }
+    }
+}
+
+TransitionTable Regex::powerset() const {
+    return combine({this});
+}
+
+TransitionTable Regex::combine(const std::vector<const Regex*>& regexes) {
+    const std::size_t none = INT_MAX;
+
+    // The states of all regexes share a single numbering, in which
+    // the states of the k-th regex start at offsets[k]
+    std::vector<std::size_t> offsets;
+    std::vector<std::size_t> owners;
+    std::size_t numStates = 0;
+    ByteClasses classes;
+    for (std::size_t k = 0; k < regexes.size(); k++) {
+        offsets.push_back(numStates);
+        numStates += regexes[k]->stateList.size();
+        owners.resize(numStates, k);
+        for (auto& state : regexes[k]->stateList) {
+            for (auto& transition : state.compiled) {
+                classes.split(transition.first);
+            }
+        }
+    }
+    auto symbols = classes.representatives();
+
+    // Returns the target of a global state on a byte class
+    // (none if there's no transition).
+    auto target = [&](std::size_t state, std::size_t symbol) {
+        const Regex& regex = *regexes[owners[state]];
+        std::size_t local = state - offsets[owners[state]];
+        std::size_t column = regex.byteClasses[symbols[symbol]];
+        std::size_t result = regex.nfaTargets[local * regex.byteClasses.size() + column];
+        return (result == none) ? none : result + offsets[owners[state]];
+    };
+
+    // Each DFA state is a sorted set of NFA states
+    std::map<std::vector<std::size_t>, TransitionTable::Index> ids;
+    std::vector<std::vector<std::size_t>> subsets;
+    auto find = [&](std::vector<std::size_t>&& subset) {
+        if (subset.empty()) {
+            return TransitionTable::dead;
+        }
+        auto it = ids.find(subset);
+        if (it != ids.end()) {
+            return it->second;
+        }
+        TransitionTable::Index id = subsets.size();
+        ids.emplace(subset, id);
+        subsets.push_back(std::move(subset));
+        return id;
+    };
+
+    std::vector<std::size_t> initial;
+    for (std::size_t k = 0; k < regexes.size(); k++) {
+        if (regexes[k]->stateList.empty()) {
+            continue;
+        }
+        for (std::size_t s : regexes[k]->closures[0]) {
+            initial.push_back(s + offsets[k]);
+        }
+    }
+    find(std::move(initial));
+
+    std::vector<std::vector<TransitionTable::Index>> rows;
+    std::vector<bool> added(numStates, false);
+    for (std::size_t i = 0; i < subsets.size(); i++) {
+        rows.emplace_back(symbols.size(), TransitionTable::dead);
+        for (std::size_t a = 0; a < symbols.size(); a++) {
+            std::vector<std::size_t> next;
+            for (std::size_t state : subsets[i]) {
+                std::size_t t = target(state, a);
+                if (t == none) {
+                    continue;
+                }
+                std::size_t offset = offsets[owners[t]];
+                for (std::size_t s : regexes[owners[t]]->closures[t - offset]) {
+                    if (!added[s + offset]) {
+                        added[s + offset] = true;
+                        next.push_back(s + offset);
+                    }
+                }
+            }
+            for (std::size_t s : next) {
+                added[s] = false;
+            }
+            std::sort(next.begin(), next.end());
+            rows[i][a] = find(std::move(next));
+        }
+    }
+
+    TransitionTable result(subsets.size(), classes);
+    for (std::size_t i = 0; i < subsets.size(); i++) {
+        for (std::size_t a = 0; a < symbols.size(); a++) {
+            if (rows[i][a] != TransitionTable::dead) {
+                result.addTransition(i, rows[i][a], symbols[a]);
+            }
+        }
+        // Since subsets are sorted, the first accepting state found
+        // belongs to the first regex that accepts
+        for (std::size_t state : subsets[i]) {
+            std::size_t k = owners[state];
+            if (state - offsets[k] == regexes[k]->acceptingState) {
+                result.accept(i, k);
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+std::vector<std::size_t> Regex::step(const std::vector<std::size_t>& states,
+    char c) const {
+
+    std::vector<std::size_t> result;
+    for (std::size_t state : states) {
+        std::size_t target = nfaTargets[state * byteClasses.size() + byteClasses[c]];
+        if (target < INT_MAX) {
+            auto& closure = closures[target];
+            result.insert(result.end(), closure.begin(), closure.end());
+        }
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+void Regex::lazyRead(char c) {
+    if (dfaState == TransitionTable::dead) {
+        return;
+    }
+
+    std::size_t slot = dfaState * 256 + static_cast<unsigned char>(c);
+    long target = cache.transitions[slot];
+    if (target != LazyCache::unknown) {
+        dfaState = target;
+        return;
+    }
+
+    auto pair = lazyFind(step(cache.subsets[dfaState], c));
+    if (!pair.second) {
+        // The source state is gone if the cache was flushed
+        cache.transitions[slot] = pair.first;
+    }
+    dfaState = pair.first;
+}
+
+std::pair<long, bool> Regex::lazyFind(std::vector<std::size_t>&& subset) {
+    if (subset.empty()) {
+        return {TransitionTable::dead, false};
+    }
+
+    auto it = cache.ids.find(subset);
+    if (it != cache.ids.end()) {
+        return {it->second, false};
+    }
+
+    bool flushed = false;
+    if (cache.subsets.size() >= cache.limit) {
+        flush();
+        flushed = true;
+        it = cache.ids.find(subset);
+        if (it != cache.ids.end()) {
+            return {it->second, true};
+        }
+    }
+
+    long id = cache.subsets.size();
+    bool accepts = std::binary_search(subset.begin(), subset.end(), acceptingState);
+    cache.ids.emplace(subset, id);
+    cache.subsets.push_back(std::move(subset));
+    cache.transitions.resize(cache.transitions.size() + 256, LazyCache::unknown);
+    cache.accepting.push_back(accepts);
+    return {id, flushed};
+}
+
+void Regex::flush() {
+    cache.ids.clear();
+    cache.subsets.clear();
+    cache.transitions.clear();
+    cache.accepting.clear();
+    lazyFind(std::vector<std::size_t>(closures[0]));
 }
 
 void Regex::debug(const Composition& comp) const {
@@ -385,70 +695,70 @@ void Regex::debug(const Composition& comp) const {
 }
 
 std::size_t Regex::State::read(char c) const {
-    for (auto& pair : transitions) {
-        bool ok = false;
-        if (pair.first.front() == '[' && pair.first.back() == ']') {
-            char buffer = '\0';
-            bool validBuffer = false;
-            bool intervalMode = false;
-            bool invertClass = false;
-            std::size_t length = pair.first.size();
-            for (std::size_t i = 1; i < length - 1; i++) {
-                char s = pair.first[i];
-                if (s == '^' && i == 1) {
-                    invertClass = true;
-                    continue;
-                }
-
-                if (s == '-' && validBuffer) {
-                    validBuffer = false;
-                    intervalMode = true;
-                    continue;
-                }
+    for (auto& transition : compiled) {
+        if (transition.first[static_cast<unsigned char>(c)]) {
+            return transition.second;
+        }
+    }
+    return INT_MAX;
+}
 
-                if (intervalMode) {
-                    if (buffer <= c && c <= s) {
-                        ok = true;
-                        break;
-                    }
-                    intervalMode = false;
-                    continue;
-                }
+std::bitset<256> Regex::compilePattern(const Pattern& pattern) {
+    std::bitset<256> result;
+    auto set = [&result](char c) {
+        result.set(static_cast<unsigned char>(c));
+    };
 
-                if (!validBuffer) {
-                    buffer = s;
-                    validBuffer = true;
-                    continue;
-                }
+    if (pattern.front() == '[' && pattern.back() == ']') {
+        char buffer = '\0';
+        bool validBuffer = false;
+        bool intervalMode = false;
+        bool invertClass = false;
+        std::size_t length = pattern.size();
+        for (std::size_t i = 1; i < length - 1; i++) {
+            char s = pattern[i];
+            if (s == '^' && i == 1) {
+                invertClass = true;
+                continue;
+            }
 
-                if (c == buffer) {
-                    ok = true;
-                    break;
-                }
-                buffer = s;
+            if (s == '-' && validBuffer) {
+                validBuffer = false;
+                intervalMode = true;
+                continue;
             }
 
             if (intervalMode) {
-                buffer = '-';
-                validBuffer = true;
+                for (int c = buffer; c <= s; c++) {
+                    set(c);
+                }
+                intervalMode = false;
+                continue;
             }
 
-            if (validBuffer && c == buffer) {
-                ok = true;
+            if (validBuffer) {
+                set(buffer);
             }
+            buffer = s;
+            validBuffer = true;
+        }
 
-            if (invertClass) {
-                ok = !ok;
-            }
-        } else if (pair.first == PATTERN_WILDCARD) {
-            ok = true;
-        } else if (c == pair.first.front()) {
-            ok = true;
+        if (intervalMode) {
+            buffer = '-';
+            validBuffer = true;
         }
 
-        if (ok) {
-            return pair.second;
+        if (validBuffer) {
+            set(buffer);
         }
+
+        if (invertClass) {
+            result.flip();
+        }
+    } else if (pattern == PATTERN_WILDCARD) {
+        result.set();
+    } else {
+        set(pattern.front());
     }
-    return INT_MAX;
+    return result;
 }
@@ -0,0 +1,71 @@
+/* created by Ghabriel Nunes <ghabriel.nunes@gmail.com> [2016] */
+
+#include <cassert>
+#include "TransitionTable.hpp"
+
+const TransitionTable::Index TransitionTable::dead;
+const TransitionTable::Tag TransitionTable::untagged;
+
+TransitionTable::TransitionTable() : numColumns(1), initialStateIndex(dead) {
+    columnMap.fill(0);
+}
+
+TransitionTable::TransitionTable(std::size_t numStates, const ByteClasses& classes)
+    : table(numStates * classes.size(), dead), tags(numStates, untagged),
+      columnMap(classes.map()), numColumns(classes.size()),
+      initialStateIndex(numStates > 0 ? 0 : dead) {}
+
+std::size_t TransitionTable::size() const {
+    return tags.size();
+}
+
+std::size_t TransitionTable::columns() const {
+    return numColumns;
+}
+
+TransitionTable::Index TransitionTable::initialState() const {
+    return initialStateIndex;
+}
+
+void TransitionTable::initialState(Index state) {
+    assert(state == dead || static_cast<std::size_t>(state) < size());
+    initialStateIndex = state;
+}
+
+void TransitionTable::addTransition(Index from, Index to, char input) {
+    assert(static_cast<std::size_t>(from) < size());
+    table[from * numColumns + columnMap[static_cast<unsigned char>(input)]] = to;
+}
+
+void TransitionTable::accept(Index state, Tag tag) {
+    assert(tag != untagged);
+    tags[state] = tag;
+}
+
+TransitionTable::Index TransitionTable::run(const char* begin, const char* end,
+    Index state) const {
+
+    const Index* base = table.data();
+    while (begin != end && state != dead) {
+        state = base[state * numColumns + columnMap[static_cast<unsigned char>(*begin)]];
+        begin++;
+    }
+    return state;
+}
+
+TransitionTable::Index TransitionTable::run(const std::string& input) const {
+    return run(input.data(), input.data() + input.size(), initialStateIndex);
+}
+
+bool TransitionTable::matches(const std::string& input) const {
+    return accepts(run(input));
+}
+
+std::vector<bool> TransitionTable::matchAll(const std::vector<std::string>& inputs) const {
+    std::vector<bool> result;
+    result.reserve(inputs.size());
+    for (auto& input : inputs) {
+        result.push_back(matches(input));
+    }
+    return result;
+}
@@ -0,0 +1,241 @@
+/* created by Ghabriel Nunes <ghabriel.nunes@gmail.com> [2016] */
+#include <algorithm>
+#include "Lexer.hpp"
+#include "parsers/Earley.hpp"
+
+const std::size_t parser::Earley::none;
+
+parser::Earley::Earley(const CFG& cfg) : Parser(cfg) {
+    for (std::size_t i = 0; i < cfg.size(); i++) {
+        const auto& ids = cfg[i].getProductIds();
+        firstRule.push_back(rules.size());
+        names.push_back(cfg[i].getNameId());
+        for (std::size_t dot = 0; dot <= ids.size(); dot++) {
+            rules.push_back(Rule{i, (dot < ids.size()) ? ids[dot] : CFG::npos});
+        }
+    }
+
+    // <S'> ::= <S>
+    firstRule.push_back(rules.size());
+    names.push_back(CFG::npos);
+    rules.push_back(Rule{cfg.size(), (cfg.size() > 0) ? cfg[0].getNameId() : CFG::npos});
+    rules.push_back(Rule{cfg.size(), CFG::npos});
+    acceptRule = rules.size() - 1;
+
+    for (SymbolId symbol = 0; symbol < cfg.numSymbols(); symbol++) {
+        nullable.push_back(!cfg.isTerminal(symbol) && cfg.nullable(symbol));
+    }
+    endName = freshName(cfg, "EOS");
+}
+
+ParseResults parser::Earley::parse(const std::vector<Token>& tokens) {
+    return run(tokens);
+}
+
+ParseResults parser::Earley::parse(const std::vector<SymbolId>& tokens) {
+    return run(tokens);
+}
+
+template<typename T>
+ParseResults parser::Earley::run(const std::vector<T>& tokens) {
+    ParseResults results;
+    results.accepted = false;
+    const CFG& cfg = getCFG();
+    items.clear();
+    waiting.clear();
+    leoItems.clear();
+    setStart.assign(1, 0);
+    waitingStart.assign(1, 0);
+    leoStart.assign(1, 0);
+    ruleMark.assign(rules.size(), none);
+    ruleHead.resize(rules.size());
+    predicted.assign(cfg.numSymbols(), none);
+
+    add(firstRule.back(), 0);
+    std::size_t length = tokens.size();
+    std::size_t position = 0;
+    while (true) {
+        process();
+        finish();
+        if (position == length) {
+            break;
+        }
+
+        // Scanner
+        SymbolId symbol = terminal(tokens[position]);
+        setStart.push_back(items.size());
+        if (symbol != CFG::npos) {
+            auto range = waitingFor(position, symbol);
+            for (std::size_t i = range.first; i < range.second; i++) {
+                Item item = items[waiting[i].second];
+                add(item.rule + 1, item.origin);
+            }
+        }
+
+        if (setStart.back() == items.size()) {
+            break;
+        }
+        position++;
+    }
+
+    if (position < length || ruleMark[acceptRule] != length) {
+        const TokenType& type = (position < length) ? typeOf(tokens[position]) : endName;
+        return error(tokens, position, "Unexpected token '" + type + "'");
+    }
+
+    results.accepted = true;
+    return results;
+}
+
+bool parser::Earley::canParse() const {
+    return getCFG().size() > 0;
+}
+
+std::size_t parser::Earley::numItems() const {
+    return items.size();
+}
+
+parser::Earley::SymbolId parser::Earley::terminal(const Token& token) const {
+    SymbolId symbol = getCFG().id(token.type);
+    return (symbol != CFG::npos && getCFG().isTerminal(symbol)) ? symbol : CFG::npos;
+}
+
+parser::Earley::SymbolId parser::Earley::terminal(SymbolId symbol) const {
+    const CFG& cfg = getCFG();
+    return (symbol < cfg.numSymbols() && cfg.isTerminal(symbol)) ? symbol : CFG::npos;
+}
+
+void parser::Earley::add(unsigned rule, std::size_t origin) {
+    std::size_t set = setStart.size() - 1;
+    if (ruleMark[rule] != set) {
+        ruleMark[rule] = set;
+        ruleHead[rule] = none;
+    }
+
+    for (std::size_t i = ruleHead[rule]; i != none; i = items[i].sameRule) {
+        if (items[i].origin == origin) {
+            return;
+        }
+    }
+    items.push_back(Item{rule, origin, ruleHead[rule]});
+    ruleHead[rule] = items.size() - 1;
+
+    // Nullable symbols may derive nothing, so they're skipped right away
+    SymbolId next = rules[rule].next;
+    if (next != CFG::npos && nullable[next]) {
+        add(rule + 1, origin);
+    }
+}
+
+void parser::Earley::process() {
+    const CFG& cfg = getCFG();
+    std::size_t set = setStart.size() - 1;
+    // The set grows as it's processed
+    for (std::size_t i = setStart.back(); i < items.size(); i++) {
+        unsigned rule = items[i].rule;
+        std::size_t origin = items[i].origin;
+        SymbolId next = rules[rule].next;
+
+        if (next != CFG::npos) {
+            // Predictor
+            if (!cfg.isTerminal(next) && predicted[next] != set) {
+                predicted[next] = set;
+                for (std::size_t production : cfg.productionsOf(next)) {
+                    add(firstRule[production], set);
+                }
+            }
+            continue;
+        }
+
+        // Completer. Empty completions were already done by the predictor,
+        // when the nullable symbols were skipped.
+        SymbolId name = names[rules[rule].production];
+        if (origin == set || name == CFG::npos) {
+            continue;
+        }
+
+        const LeoItem* leo = leoFor(origin, name);
+        if (leo) {
+            add(leo->rule, leo->origin);
+            continue;
+        }
+
+        auto range = waitingFor(origin, name);
+        for (std::size_t j = range.first; j < range.second; j++) {
+            Item item = items[waiting[j].second];
+            add(item.rule + 1, item.origin);
+        }
+    }
+}
+
+void parser::Earley::finish() {
+    const CFG& cfg = getCFG();
+    std::size_t set = setStart.size() - 1;
+    std::size_t begin = waiting.size();
+    for (std::size_t i = setStart.back(); i < items.size(); i++) {
+        SymbolId next = rules[items[i].rule].next;
+        if (next != CFG::npos) {
+            waiting.push_back({next, i});
+        }
+    }
+    std::sort(waiting.begin() + begin, waiting.end());
+
+    // A symbol expected by a single item which ends right after it starts
+    // a deterministic chain of completions
+    std::size_t leoBegin = leoItems.size();
+    for (std::size_t i = begin; i < waiting.size(); i++) {
+        SymbolId symbol = waiting[i].first;
+        bool single = (i + 1 == waiting.size() || waiting[i + 1].first != symbol)
+                   && (i == begin || waiting[i - 1].first != symbol);
+        const Item& item = items[waiting[i].second];
+        if (single && !cfg.isTerminal(symbol) && rules[item.rule + 1].next == CFG::npos) {
+            leoItems.push_back(LeoItem{symbol, item.rule + 1, item.origin});
+        }
+    }
+    leoStart.push_back(leoItems.size());
+    waitingStart.push_back(waiting.size());
+
+    // Follows each chain up to its topmost item. Chains of this set are
+    // bounded by its number of Leo items, which also breaks cycles.
+    std::size_t count = leoItems.size() - leoBegin;
+    for (std::size_t i = leoBegin; i < leoItems.size(); i++) {
+        LeoItem& leo = leoItems[i];
+        for (std::size_t steps = 0; steps <= count; steps++) {
+            SymbolId name = names[rules[leo.rule].production];
+            const LeoItem* next = (name != CFG::npos) ? leoFor(leo.origin, name) : nullptr;
+            if (!next || next == &leo) {
+                break;
+            }
+            leo.rule = next->rule;
+            leo.origin = next->origin;
+            if (next->origin < set) {
+                break;
+            }
+        }
+    }
+}
+
+std::pair<std::size_t, std::size_t> parser::Earley::waitingFor(std::size_t set,
+    SymbolId symbol) const {
+
+    auto begin = waiting.begin() + waitingStart[set];
+    auto end = waiting.begin() + waitingStart[set + 1];
+    auto range = std::equal_range(begin, end, std::make_pair(symbol, std::size_t(0)),
+        [](const std::pair<SymbolId, std::size_t>& lhs,
+           const std::pair<SymbolId, std::size_t>& rhs) {
+            return lhs.first < rhs.first;
+        });
+    return {range.first - waiting.begin(), range.second - waiting.begin()};
+}
+
+const parser::Earley::LeoItem* parser::Earley::leoFor(std::size_t set,
+    SymbolId symbol) const {
+
+    auto begin = leoItems.begin() + leoStart[set];
+    auto end = leoItems.begin() + leoStart[set + 1];
+    auto it = std::lower_bound(begin, end, symbol,
+        [](const LeoItem& leo, SymbolId symbol) {
+            return leo.symbol < symbol;
+        });
+    return (it != end && it->symbol == symbol) ? &*it : nullptr;
+}
@@ -0,0 +1,273 @@
+/* created by Ghabriel Nunes <ghabriel.nunes@gmail.com> [2016] */
+#include <algorithm>
+#include "Lexer.hpp"
+#include "parsers/GLR.hpp"
+
+const std::size_t parser::GLR::none;
+
+namespace {
+    // Empties a map in time proportional to its size. clear() also visits
+    // every bucket, which may be many more after a large level.
+    template<typename Map>
+    void reset(Map& map) {
+        if (map.bucket_count() > 2 * map.size() + 16) {
+            Map().swap(map);
+        } else {
+            map.clear();
+        }
+    }
+}
+
+parser::GLR::GLR(const CFG& cfg) : LALR1(cfg, true) {}
+
+template<typename Callback>
+void parser::GLR::forEachAction(State state, unsigned terminal,
+    const Callback& callback) const {
+
+    LRTable::Entry entry = table.action(state, terminal);
+    if (LRTable::kind(entry) == Action::CONFLICT) {
+        for (LRTable::Entry action : table.conflicts(entry)) {
+            callback(action);
+        }
+    } else {
+        callback(entry);
+    }
+}
+
+ParseResults parser::GLR::parse(const std::vector<Token>& tokens) {
+    return run(tokens);
+}
+
+ParseResults parser::GLR::parse(const std::vector<SymbolId>& tokens) {
+    return run(tokens);
+}
+
+template<typename T>
+ParseResults parser::GLR::run(const std::vector<T>& tokens) {
+    ParseResults results;
+    results.accepted = false;
+    nodes.clear();
+    links.clear();
+    forestNodes.clear();
+    packed.clear();
+    packedChildren.clear();
+    rootNode = none;
+    steps = 0;
+    nodeByState.assign(table.size(), none);
+
+    nodes.push_back(StackNode{0, 0, none, none});
+    nodeByState[0] = 0;
+    frontier.assign(1, 0);
+
+    std::size_t length = tokens.size();
+    for (position = 0; position <= length; position++) {
+        unsigned currToken = (position < length)
+                           ? column(tokens[position])
+                           : endOfSentence;
+
+        // Reducer: the frontier grows as the reductions are done
+        reset(forestByKey);
+        reductions.clear();
+        for (std::size_t i = 0; i < frontier.size(); i++) {
+            enqueue(frontier[i], currToken, none);
+        }
+        while (!reductions.empty()) {
+            Reduction reduction = reductions.back();
+            reductions.pop_back();
+            reduce(reduction, currToken);
+        }
+
+        if (position == length) {
+            for (std::size_t node : frontier) {
+                forEachAction(nodes[node].state, currToken, [&](LRTable::Entry entry) {
+                    if (LRTable::kind(entry) == Action::ACCEPT) {
+                        // The only link of an accepting node comes from
+                        // the initial one, through the start symbol
+                        rootNode = links[nodes[node].firstLink].forestNode;
+                    }
+                });
+            }
+            break;
+        }
+
+        // Shifter
+        std::size_t leaf = forestNodes.size();
+        forestNodes.push_back(ForestNode{CFG::npos, position, position + 1, none});
+        for (std::size_t node : frontier) {
+            nodeByState[nodes[node].state] = none;
+        }
+
+        // Only the links of the new nodes can be looked up from now on
+        reset(linkByNodes);
+        std::vector<std::size_t> shifted;
+        for (std::size_t node : frontier) {
+            forEachAction(nodes[node].state, currToken, [&](LRTable::Entry entry) {
+                if (LRTable::kind(entry) != Action::SHIFT) {
+                    return;
+                }
+                State target = LRTable::target(entry);
+                if (nodeByState[target] == none) {
+                    nodeByState[target] = nodes.size();
+                    shifted.push_back(nodes.size());
+                    nodes.push_back(StackNode{target, position + 1, none, none});
+                }
+                addLink(nodeByState[target], node, leaf);
+            });
+        }
+
+        if (shifted.empty()) {
+            break;
+        }
+        frontier = std::move(shifted);
+    }
+
+    if (rootNode == none) {
+        std::size_t index = std::min(position, length);
+        return error(tokens, index, "Unexpected token '" + typeAt(tokens, index) + "'");
+    }
+
+    results.accepted = true;
+    return results;
+}
+
+const std::vector<parser::GLR::ForestNode>& parser::GLR::forest() const {
+    return forestNodes;
+}
+
+const std::vector<parser::GLR::PackedNode>& parser::GLR::packedNodes() const {
+    return packed;
+}
+
+const std::vector<std::size_t>& parser::GLR::children() const {
+    return packedChildren;
+}
+
+std::size_t parser::GLR::root() const {
+    return rootNode;
+}
+
+std::size_t parser::GLR::numSteps() const {
+    return steps;
+}
+
+void parser::GLR::enqueue(std::size_t node, unsigned terminal, std::size_t link) {
+    forEachAction(nodes[node].state, terminal, [&](LRTable::Entry entry) {
+        if (LRTable::kind(entry) != Action::REDUCE) {
+            return;
+        }
+        std::size_t production = LRTable::target(entry);
+        // Empty reductions don't follow any link
+        if (link == none || lengths[production] > 0) {
+            reductions.push_back(Reduction{node, production, link});
+        }
+    });
+}
+
+void parser::GLR::reduce(const Reduction& reduction, unsigned terminal) {
+    path.clear();
+    walk(reduction.node, lengths[reduction.production], reduction.link,
+        reduction.link == none, reduction.production, terminal);
+}
+
+void parser::GLR::walk(std::size_t node, std::size_t remaining, std::size_t link,
+    bool linkUsed, std::size_t production, unsigned terminal) {
+
+    steps++;
+    if (remaining == 0) {
+        if (linkUsed) {
+            push(node, production, terminal);
+        }
+        return;
+    }
+
+    // New links are inserted at the front, so they aren't visited here
+    if (linkUsed) {
+        for (std::size_t l = nodes[node].firstLink; l != none; l = links[l].next) {
+            follow(l, remaining, link, true, production, terminal);
+        }
+        return;
+    }
+
+    // The nodes before the required link are at the current position, so
+    // only the local links and the required one may be followed until then
+    if (links[link].source == node) {
+        follow(link, remaining, link, true, production, terminal);
+    }
+    for (std::size_t l = nodes[node].firstLocalLink; l != none; l = links[l].nextLocal) {
+        if (l != link) {
+            follow(l, remaining, link, false, production, terminal);
+        }
+    }
+}
+
+void parser::GLR::follow(std::size_t l, std::size_t remaining, std::size_t link,
+    bool linkUsed, std::size_t production, unsigned terminal) {
+
+    path.push_back(links[l].forestNode);
+    walk(links[l].target, remaining - 1, link, linkUsed, production, terminal);
+    path.pop_back();
+}
+
+void parser::GLR::push(std::size_t node, std::size_t production, unsigned terminal) {
+
+    unsigned name = names[production];
+    State target = table.go(nodes[node].state, name);
+
+    // Finds the forest node of this symbol and span
+    std::size_t start = nodes[node].position;
+    auto insertion = forestByKey.emplace(key(name, start), forestNodes.size());
+    std::size_t forestNode = insertion.first->second;
+    if (insertion.second) {
+        SymbolId symbol = augmented[production].getNameId();
+        forestNodes.push_back(ForestNode{symbol, start, position, none});
+    }
+
+    // The path was collected backwards
+    std::size_t& first = forestNodes[forestNode].firstAlternative;
+    bool known = false;
+    for (std::size_t i = first; i != none && !known; i = packed[i].next) {
+        known = packed[i].production == production
+            && std::equal(path.rbegin(), path.rend(), packedChildren.begin() + packed[i].childrenBegin);
+    }
+    if (!known) {
+        std::size_t begin = packedChildren.size();
+        packedChildren.insert(packedChildren.end(), path.rbegin(), path.rend());
+        packed.push_back(PackedNode{production, first, begin, packedChildren.size()});
+        first = packed.size() - 1;
+    }
+
+    std::size_t top = nodeByState[target];
+    if (top == none) {
+        top = nodes.size();
+        nodeByState[target] = top;
+        nodes.push_back(StackNode{target, position, none, none});
+        frontier.push_back(top);
+        addLink(top, node, forestNode);
+        enqueue(top, terminal, none);
+    } else if (findLink(top, node) == none) {
+        // The paths through the new link must be reduced as well, even
+        // from nodes that were already processed
+        std::size_t link = addLink(top, node, forestNode);
+        for (std::size_t i = 0; i < frontier.size(); i++) {
+            enqueue(frontier[i], terminal, link);
+        }
+    }
+}
+
+std::size_t parser::GLR::findLink(std::size_t from, std::size_t to) const {
+    auto it = linkByNodes.find(key(from, to));
+    return (it == linkByNodes.end()) ? none : it->second;
+}
+
+std::size_t parser::GLR::addLink(std::size_t from, std::size_t to, std::size_t forestNode) {
+    std::size_t l = links.size();
+    StackNode& source = nodes[from];
+    linkByNodes.emplace(key(from, to), l);
+    links.push_back(Link{from, to, forestNode, source.firstLink, none});
+    source.firstLink = l;
+    if (nodes[to].position == source.position) {
+        links[l].nextLocal = source.firstLocalLink;
+        source.firstLocalLink = l;
+    }
+    return l;
+}
@@ -0,0 +1,100 @@
+/* created by Ghabriel Nunes <ghabriel.nunes@gmail.com> [2016] */
+#include <unordered_map>
+#include "Lexer.hpp"
+#include "parsers/LALR1.hpp"
+
+parser::LALR1::LALR1(const CFG& cfg) : LALR1(cfg, false) {}
+
+parser::LALR1::LALR1(const CFG& cfg, bool keepConflicts) : LRParser(cfg) {
+    auto lr0 = parser::LR0(cfg);
+    std::size_t numStates = lr0.size();
+    std::size_t numSymbols = augmented.numSymbols();
+
+    // transitions[p][X] is the state reached from p through X. The
+    // non-terminal transitions are also numbered, since they are the
+    // nodes of the reads and includes relations.
+    std::vector<std::unordered_map<SymbolId, std::size_t>> transitions(numStates);
+    std::vector<std::unordered_map<SymbolId, std::size_t>> gotoIndex(numStates);
+    std::vector<std::pair<std::size_t, SymbolId>> gotos;
+    for (std::size_t p = 0; p < numStates; p++) {
+        for (auto& item : lr0[p].items) {
+            if (item.action != Action::SHIFT && item.action != Action::GOTO) {
+                continue;
+            }
+            const Production& prod = augmented[item.productionNumber];
+            SymbolId symbol = prod.getProductIds()[item.position];
+            transitions[p][symbol] = item.targetState;
+            if (item.action == Action::GOTO && gotoIndex[p].emplace(symbol, gotos.size()).second) {
+                gotos.emplace_back(p, symbol);
+            }
+        }
+    }
+
+    // Direct reads: the terminals that can be read right after a
+    // non-terminal transition. The terminal of <S'> ::= <S>.EOS is
+    // accepted instead of shifted, but counts as well.
+    // (p, A) reads (r, C) if p --A--> r --C--> and C is nullable.
+    std::vector<IndexList> sets(gotos.size(), IndexList(numSymbols, false));
+    std::vector<std::vector<std::size_t>> relation(gotos.size());
+    for (std::size_t t = 0; t < gotos.size(); t++) {
+        std::size_t r = transitions[gotos[t].first][gotos[t].second];
+        for (auto& item : lr0[r].items) {
+            const Production& prod = augmented[item.productionNumber];
+            if (item.position < prod.size()) {
+                SymbolId symbol = prod.getProductIds()[item.position];
+                if (augmented.isTerminal(symbol)) {
+                    sets[t].insert(symbol);
+                }
+            }
+        }
+
+        for (auto& pair : gotoIndex[r]) {
+            if (augmented.nullable(pair.first)) {
+                relation[t].push_back(pair.second);
+            }
+        }
+    }
+    utils::digraph(sets, relation);
+
+    // (p, A) includes (p', B) if B ::= xAy, y is nullable and p' --x--> p.
+    // lookback[q][i] lists the transitions (p, A) such that the
+    // production i has A as its left side and p --(right side)--> q.
+    for (auto& edges : relation) {
+        edges.clear();
+    }
+    std::vector<std::unordered_map<std::size_t, std::vector<std::size_t>>> lookback(numStates);
+    std::vector<bool> nullableSuffix;
+    for (std::size_t t = 0; t < gotos.size(); t++) {
+        for (std::size_t i : augmented.productionsOf(gotos[t].second)) {
+            auto& products = augmented[i].getProductIds();
+            nullableSuffix.assign(products.size() + 1, true);
+            for (std::size_t j = products.size(); j > 0; j--) {
+                SymbolId symbol = products[j - 1];
+                nullableSuffix[j - 1] = nullableSuffix[j]
+                    && !augmented.isTerminal(symbol) && augmented.nullable(symbol);
+            }
+
+            std::size_t state = gotos[t].first;
+            for (std::size_t j = 0; j < products.size(); j++) {
+                SymbolId symbol = products[j];
+                if (!augmented.isTerminal(symbol) && nullableSuffix[j + 1]) {
+                    relation[gotoIndex[state][symbol]].push_back(t);
+                }
+                state = transitions[state][symbol];
+            }
+            lookback[state][i].push_back(t);
+        }
+    }
+    utils::digraph(sets, relation);
+
+    // The lookaheads of a reduction are the union of the follow sets
+    // of the transitions it looks back to
+    IndexList lookaheads(numSymbols, false);
+    build(lr0, [&](std::size_t state, std::size_t item) -> const IndexList& {
+        lookaheads = IndexList(numSymbols, false);
+        for (std::size_t t : lookback[state][lr0[state].items[item].productionNumber]) {
+            lookaheads.merge(sets[t]);
+        }
+        return lookaheads;
+    }, keepConflicts);
+}
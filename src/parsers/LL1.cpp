@@ -8,120 +8,166 @@ namespace {
     const std::string END_OF_SENTENCE = "EOS";
 }
 
+const unsigned parser::LL1::noProduction;
+
 parser::LL1::LL1(const CFG& cfg) : Parser(cfg) {
     cfg.prepareFirst();
-    for (std::size_t i = 0; i < cfg.size(); i++) {
+
+    // Assigns a row to each non-terminal and a column to each terminal
+    const unsigned none = -1;
+    std::vector<unsigned> rowOf(cfg.numSymbols(), none);
+    columnOf.assign(cfg.numSymbols(), none);
+    std::vector<Symbol> rowNames;
+    std::vector<SymbolId> rowSymbols;
+    for (SymbolId symbol = 0; symbol < cfg.numSymbols(); symbol++) {
+        if (cfg.isTerminal(symbol)) {
+            columnOf[symbol] = columnByType.size();
+            columnByType.emplace(cfg.symbol(symbol), columnOf[symbol]);
+            names.push_back(cfg.symbol(symbol));
+            symbols.push_back(symbol);
+        } else {
+            rowOf[symbol] = rowNames.size();
+            rowNames.push_back(cfg.symbol(symbol));
+            rowSymbols.push_back(symbol);
+        }
+    }
+
+    numRows = rowNames.size();
+    unsigned endOfSentence = names.size();
+    names.push_back(END_OF_SENTENCE);
+    numColumns = names.size() + 1;
+    for (unsigned& column : columnOf) {
+        if (column == none) {
+            column = numColumns - 1;
+        }
+    }
+    names.insert(names.begin(), rowNames.begin(), rowNames.end());
+    symbols.insert(symbols.begin(), rowSymbols.begin(), rowSymbols.end());
+    table.assign(numRows * numColumns, noProduction);
+
+    SymbolId endOfInput = cfg.endOfInput();
+    for (std::size_t i = 0; i < cfg.size() && !conflict; i++) {
         const Production& prod = cfg[i];
-        std::string prodName = prod.getName();
-        auto& row = table[prodName];
-        for (auto& symbol : prod.getFirstSet()) {
-            if (row.count(symbol) > 0) {
+        unsigned* row = &table[rowOf[prod.getNameId()] * numColumns];
+        auto fill = [&](SymbolId symbol) {
+            unsigned column = (symbol == endOfInput) ? endOfSentence : columnOf[symbol];
+            if (row[column] != noProduction) {
                 conflict = true;
-                return;
             }
-            row[symbol] = i;
-        }
+            row[column] = i;
+        };
+
+        prod.getFirstSet().forEach(fill);
 
         if (prod.isNullable()) {
-            auto follow = cfg.follow(prodName);
-            if (cfg.endable(prodName)) {
-                follow.insert(END_OF_SENTENCE);
-            }
-            for (auto& symbol : follow) {
-                if (row.count(symbol) > 0) {
-                    conflict = true;
-                    return;
-                }
-                row[symbol] = i;
-            }
+            // The follow set includes endOfInput if the name is endable
+            cfg.followOf(prod.getNameId()).forEach(fill);
         }
     }
 
-    // for (auto& pair : table) {
-    //     TRACE(pair.first);
-    //     for (auto& p : pair.second) {
-    //         ECHO(p.first + " -> " + std::to_string(p.second));
-    //     }
-    // }
+    start = (cfg.size() > 0) ? rowOf[cfg[0].getNameId()] : noProduction;
+    offsets.push_back(0);
+    for (auto& prod : cfg) {
+        for (SymbolId symbol : utils::make_reverse(prod.getProductIds())) {
+            bool terminal = cfg.isTerminal(symbol);
+            products.push_back(terminal ? numRows + columnOf[symbol] : rowOf[symbol]);
+        }
+        offsets.push_back(products.size());
+    }
 }
 
-ParseResults parser::LL1::parse(const std::vector<Token>& input) {
+template<typename T>
+ParseResults parser::LL1::run(const std::vector<T>& input, ParseTree* tree) {
     assert(canParse());
     ParseResults result;
     std::size_t length = input.size();
-    std::stack<TokenType> stack;
-    stack.push(END_OF_SENTENCE);
-    stack.push(getCFG()[0].getName());
+    Entry endOfSentence = numRows + numColumns - 2;
+    ParseNode* root = nullptr;
+    stack.clear();
+    stack.reserve(length + 2);
+    stack.push_back(endOfSentence);
+    if (start != noProduction) {
+        stack.push_back(start);
+    }
+    if (tree) {
+        slots.clear();
+        slots.push_back(nullptr);
+        slots.push_back(&root);
+    }
+
     for (std::size_t i = 0; i <= length; i++) {
-        const TokenType& symbol = (i < length) ? input[i].type : END_OF_SENTENCE;
-        result = unwind(stack, symbol);
-        if (!result.accepted) {
-            return error(input, i, result.errorMessage);
+        unsigned col = (i < length) ? column(input[i]) : numColumns - 2;
+        Entry top;
+        // Expands the non-terminals on top of the stack
+        while ((top = stack.back()) < numRows) {
+            unsigned index = table[top * numColumns + col];
+            if (index == noProduction) {
+                const TokenType& type = (i < length) ? typeOf(input[i]) : END_OF_SENTENCE;
+                return error(input, i, "Unexpected token '" + type + "'");
+            }
+
+            stack.pop_back();
+            stack.insert(stack.end(), products.begin() + offsets[index],
+                products.begin() + offsets[index + 1]);
+
+            if (tree) {
+                // The children are pushed in reverse order, like the entries
+                unsigned size = offsets[index + 1] - offsets[index];
+                ParseNode* node = tree->node(symbols[top], index, i, size);
+                *slots.back() = node;
+                slots.pop_back();
+                for (unsigned j = size; j > 0; j--) {
+                    slots.push_back(node->children + j - 1);
+                }
+            }
         }
 
-        if (stack.top() == symbol) {
-            stack.pop();
-            // ECHO("[POP] " + symbol);
-        } else {
-            return error(input, i, "Unexpected token '" + symbol + "', expected '" + stack.top() + "'");
+        if (top - numRows != col) {
+            const TokenType& type = (i < length) ? typeOf(input[i]) : END_OF_SENTENCE;
+            return error(input, i, "Unexpected token '" + type + "', expected '" + names[top] + "'");
+        }
+        stack.pop_back();
+        if (tree && i < length) {
+            *slots.back() = tree->leaf(symbols[top], i);
+            slots.pop_back();
         }
     }
 
-    if (!stack.empty()) {
-        return error(input, input.size(), "Unexpected end-of-sentence, expected '" + stack.top() + "'");
+    if (tree) {
+        tree->setRoot(root);
     }
-
     result.accepted = true;
     return result;
 }
 
-bool parser::LL1::canParse() const {
-    return !conflict;
+ParseResults parser::LL1::parse(const std::vector<Token>& input) {
+    return run(input, nullptr);
 }
 
-ParseResults parser::LL1::unwind(std::stack<Symbol>& stack, const Symbol& input) {
-    ParseResults result;
-    Symbol& top = stack.top();
-    if (getCFG().isTerminal(top) || top == END_OF_SENTENCE) {
-        result.accepted = true;
-        return result;
-    }
-
-    auto& row = table[top];
-    if (row.count(input) > 0) {
-        std::size_t index = row[input];
-        const Production& prod = getCFG()[index];
-        stack.pop();
-        // ECHO("[POP] " + top);
-        for (const Symbol& symbol : utils::make_reverse(prod.getProducts())) {
-            stack.push(symbol);
-            // ECHO("[PUSH] " + symbol);
-        }
-        return unwind(stack, input);
-    }
+ParseResults parser::LL1::parse(const std::vector<Token>& input, ParseTree& tree) {
+    tree.clear();
+    return run(input, &tree);
+}
 
-    result.accepted = false;
-    result.errorMessage = "Unexpected token '" + input + "'";
-    return result;
+ParseResults parser::LL1::parse(const std::vector<SymbolId>& input) {
+    return run(input, nullptr);
 }
 
-ParseResults parser::LL1::error(const std::vector<Token>& input,
-    std::size_t index, const std::string& message) const {
+ParseResults parser::LL1::parse(const std::vector<SymbolId>& input, ParseTree& tree) {
+    tree.clear();
+    return run(input, &tree);
+}
 
-    ParseResults result;
-    result.accepted = false;
-    result.errorIndex = index;
-    result.errorMessage = "Error: " + message + "\n";
-    for (std::size_t i = 0; i < index; i++) {
-        result.errorMessage += input[i].content;
-    }
+bool parser::LL1::canParse() const {
+    return !conflict;
+}
 
-    if (index < input.size()) {
-        result.errorMessage += ("\033[1;31m" + input[index].content + "\033[0m");
-        for (std::size_t i = index + 1; i < input.size(); i++) {
-            result.errorMessage += input[i].content;
-        }
-    }
+unsigned parser::LL1::column(const Token& token) const {
+    auto it = columnByType.find(token.type);
+    // Unknown tokens use the last column, which is always empty
+    return (it == columnByType.end()) ? numColumns - 1 : it->second;
+}
 
-    return result;
+unsigned parser::LL1::column(SymbolId symbol) const {
+    return (symbol < columnOf.size()) ? columnOf[symbol] : numColumns - 1;
 }
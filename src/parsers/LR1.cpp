@@ -0,0 +1,246 @@
+/* created by Ghabriel Nunes <ghabriel.nunes@gmail.com> [2016] */
+#include <algorithm>
+#include <queue>
+#include <unordered_map>
+#include "Lexer.hpp"
+#include "parsers/LR1.hpp"
+
+namespace {
+    const std::size_t none = -1;
+}
+
+parser::LR1::LR1(const CFG& cfg) : LRParser(cfg) {
+    std::vector<LR1State> states = collection();
+    std::vector<LR0State> cores;
+    cores.reserve(states.size());
+    for (auto& state : states) {
+        cores.push_back(std::move(state));
+    }
+
+    build(cores, [&](std::size_t state, std::size_t item) -> const IndexList& {
+        return states[state].lookaheads[item];
+    });
+}
+
+std::vector<parser::LR1State> parser::LR1::collection() const {
+    const CFG& grammar = augmented;
+    std::size_t last = grammar.size() - 1;
+    std::size_t numSymbols = grammar.numSymbols();
+
+    std::vector<LR1State> states;
+    // States sharing each core, in order of creation
+    std::unordered_map<LR0Kernel, std::vector<std::size_t>, LR0KernelHash> statesByCore;
+    std::queue<std::size_t> pendingStates;
+    std::vector<bool> pending;
+    std::vector<std::size_t> positions(grammar.size(), none);
+
+    // Creates the initial state. The end of the input is an explicit
+    // terminal, so its kernel has no lookaheads.
+    states.emplace_back();
+    states.back().kernel.push_back(LR0Item{last, 0});
+    states.back().lookaheads.emplace_back(numSymbols, false);
+    statesByCore[states.back().kernel].push_back(0);
+    pendingStates.push(0);
+    pending.push_back(true);
+
+    while (!pendingStates.empty()) {
+        std::size_t current = pendingStates.front();
+        pendingStates.pop();
+        pending[current] = false;
+        closure(states[current], positions);
+
+        // Groups the items by their next symbol, in order of appearance,
+        // keeping each advanced item along with its lookaheads
+        auto& items = states[current].items;
+        std::unordered_map<SymbolId, std::size_t> groupBySymbol;
+        std::vector<SymbolId> symbols;
+        std::vector<std::vector<std::pair<LR0Item, std::size_t>>> groups;
+        std::vector<std::size_t> groupOf(items.size(), none);
+        for (std::size_t i = 0; i < items.size(); i++) {
+            LR0Item& item = items[i];
+            const Production& prod = grammar[item.productionNumber];
+            if (item.position >= prod.size()) {
+                item.action = Action::REDUCE;
+                continue;
+            }
+
+            // <S'> ::= <S>.$ should accept
+            if (item.productionNumber == last && item.position == 1) {
+                item.action = Action::ACCEPT;
+                continue;
+            }
+
+            SymbolId symbol = prod.getProductIds()[item.position];
+            auto insertion = groupBySymbol.emplace(symbol, groups.size());
+            if (insertion.second) {
+                symbols.push_back(symbol);
+                groups.emplace_back();
+            }
+            groupOf[i] = insertion.first->second;
+            groups[groupOf[i]].emplace_back(LR0Item{item.productionNumber, item.position + 1}, i);
+        }
+
+        // Finds a compatible state for each group, or creates one
+        std::vector<std::size_t> targets(groups.size());
+        for (std::size_t g = 0; g < groups.size(); g++) {
+            auto& group = groups[g];
+            std::sort(group.begin(), group.end());
+            LR0Kernel kernel;
+            std::vector<IndexList> lookaheads;
+            for (auto& pair : group) {
+                kernel.push_back(pair.first);
+                lookaheads.push_back(states[current].lookaheads[pair.second]);
+            }
+
+            std::size_t target = none;
+            auto& candidates = statesByCore[kernel];
+            for (std::size_t candidate : candidates) {
+                if (compatible(states[candidate].lookaheads, lookaheads, kernel.size())) {
+                    target = candidate;
+                    break;
+                }
+            }
+
+            if (target == none) {
+                target = states.size();
+                candidates.push_back(target);
+                states.emplace_back();
+                states.back().kernel = std::move(kernel);
+                states.back().lookaheads = std::move(lookaheads);
+                pendingStates.push(target);
+                pending.push_back(true);
+            } else {
+                // The merged state must be expanded again if it grew
+                bool changed = false;
+                for (std::size_t i = 0; i < lookaheads.size(); i++) {
+                    changed = states[target].lookaheads[i].merge(lookaheads[i]) || changed;
+                }
+                if (changed && !pending[target]) {
+                    pendingStates.push(target);
+                    pending[target] = true;
+                }
+            }
+            targets[g] = target;
+        }
+
+        // Assigns the appropriate action type to each item
+        auto& state = states[current];
+        for (std::size_t i = 0; i < state.items.size(); i++) {
+            if (groupOf[i] == none) {
+                continue;
+            }
+            LR0Item& item = state.items[i];
+            item.action = grammar.isTerminal(symbols[groupOf[i]]) ? Action::SHIFT : Action::GOTO;
+            item.targetState = targets[groupOf[i]];
+        }
+    }
+
+    // Expanding a merged state again may leave its previous targets
+    // unreachable, so only the reachable states are kept
+    std::vector<std::size_t> renumbering(states.size(), none);
+    std::vector<std::size_t> order;
+    renumbering[0] = 0;
+    order.push_back(0);
+    for (std::size_t i = 0; i < order.size(); i++) {
+        for (auto& item : states[order[i]].items) {
+            bool transition = item.action == Action::SHIFT || item.action == Action::GOTO;
+            if (transition && renumbering[item.targetState] == none) {
+                renumbering[item.targetState] = order.size();
+                order.push_back(item.targetState);
+            }
+        }
+    }
+
+    std::vector<LR1State> result;
+    result.reserve(order.size());
+    for (std::size_t index : order) {
+        result.push_back(std::move(states[index]));
+        for (auto& item : result.back().items) {
+            if (item.action == Action::SHIFT || item.action == Action::GOTO) {
+                item.targetState = renumbering[item.targetState];
+            }
+        }
+    }
+    return result;
+}
+
+void parser::LR1::closure(LR1State& state, std::vector<std::size_t>& positions) const {
+    const CFG& grammar = augmented;
+    std::size_t numSymbols = grammar.numSymbols();
+    std::size_t kernelSize = state.kernel.size();
+    state.items = state.kernel;
+    expandState(state, grammar);
+    state.lookaheads.erase(state.lookaheads.begin() + kernelSize, state.lookaheads.end());
+    state.lookaheads.resize(state.items.size(), IndexList(numSymbols, false));
+
+    for (std::size_t i = 0; i < state.items.size(); i++) {
+        if (state.items[i].position == 0) {
+            positions[state.items[i].productionNumber] = i;
+        }
+    }
+
+    // Adds the first set of what follows each non-terminal to the items
+    // it expands to. If that part is nullable, the lookaheads of the item
+    // are inherited as well, which is propagated through a worklist.
+    std::vector<bool> inherits(state.items.size(), false);
+    std::vector<std::size_t> worklist;
+    IndexList firstSet(numSymbols, false);
+    for (std::size_t i = 0; i < state.items.size(); i++) {
+        const LR0Item& item = state.items[i];
+        const Production& prod = grammar[item.productionNumber];
+        if (item.position >= prod.size() || grammar.isTerminal(prod.getProductIds()[item.position])) {
+            continue;
+        }
+
+        firstSet = IndexList(numSymbols, false);
+        inherits[i] = first(prod, item.position + 1, firstSet);
+        for (std::size_t p : grammar.productionsOf(prod.getProductIds()[item.position])) {
+            state.lookaheads[positions[p]].merge(firstSet);
+        }
+        if (inherits[i]) {
+            worklist.push_back(i);
+        }
+    }
+
+    while (!worklist.empty()) {
+        std::size_t i = worklist.back();
+        worklist.pop_back();
+        const LR0Item& item = state.items[i];
+        const Production& prod = grammar[item.productionNumber];
+        for (std::size_t p : grammar.productionsOf(prod.getProductIds()[item.position])) {
+            std::size_t target = positions[p];
+            if (state.lookaheads[target].merge(state.lookaheads[i]) && inherits[target]) {
+                worklist.push_back(target);
+            }
+        }
+    }
+
+    for (auto& item : state.items) {
+        positions[item.productionNumber] = none;
+    }
+}
+
+bool parser::LR1::first(const Production& prod, std::size_t from, IndexList& result) const {
+    auto& products = prod.getProductIds();
+    for (std::size_t i = from; i < products.size(); i++) {
+        result.merge(augmented.firstOf(products[i]));
+        if (augmented.isTerminal(products[i]) || !augmented.nullable(products[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool parser::LR1::compatible(const std::vector<IndexList>& lhs,
+    const std::vector<IndexList>& rhs, std::size_t size) {
+
+    for (std::size_t i = 0; i < size; i++) {
+        for (std::size_t j = i + 1; j < size; j++) {
+            bool crossed = lhs[i].intersects(rhs[j]) || lhs[j].intersects(rhs[i]);
+            if (crossed && !lhs[i].intersects(lhs[j]) && !rhs[i].intersects(rhs[j])) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
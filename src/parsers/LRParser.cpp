@@ -0,0 +1,179 @@
+/* created by Ghabriel Nunes <ghabriel.nunes@gmail.com> [2016] */
+#include <cassert>
+#include "Lexer.hpp"
+#include "parsers/LRParser.hpp"
+
+parser::LRParser::LRParser(const CFG& cfg) : Parser(cfg), augmented(augment(cfg)) {}
+
+void parser::LRParser::build(const std::vector<LR0State>& states,
+    const std::function<const IndexList&(std::size_t, std::size_t)>& lookaheads,
+    bool keepConflicts) {
+
+    // Assigns a column to each terminal and to each non-terminal
+    std::vector<unsigned> columnOf(augmented.numSymbols());
+    unsigned numNonTerminals = 0;
+    for (SymbolId symbol = 0; symbol < augmented.numSymbols(); symbol++) {
+        if (augmented.isTerminal(symbol)) {
+            columnOf[symbol] = columnByType.size();
+            columnByType.emplace(augmented.symbol(symbol), columnOf[symbol]);
+            terminals.push_back(symbol);
+        } else {
+            columnOf[symbol] = numNonTerminals++;
+        }
+    }
+    SymbolId end = augmented[augmented.size() - 1].getProductIds().back();
+    assert(end != CFG::npos && augmented.isTerminal(end));
+    endOfSentence = columnOf[end];
+    unknown = columnByType.size();
+    for (SymbolId symbol = 0; symbol < getCFG().numSymbols(); symbol++) {
+        columnById.push_back(augmented.isTerminal(symbol) ? columnOf[symbol] : unknown);
+    }
+
+    for (auto& prod : augmented) {
+        lengths.push_back(prod.size());
+        names.push_back(columnOf[prod.getNameId()]);
+    }
+
+    table = LRTable(unknown + 1, numNonTerminals);
+    // Returns false if an action conflicts with a previous one
+    auto set = [&](unsigned column, const AscendingAction& action) {
+        if (keepConflicts) {
+            table.addAction(column, action);
+            return true;
+        }
+        return table.setAction(column, action);
+    };
+
+    for (std::size_t i = 0; i < states.size(); i++) {
+        const LR0State& state = states[i];
+        table.addState();
+        for (std::size_t j = 0; j < state.items.size(); j++) {
+            const LR0Item& item = state.items[j];
+            const Production& prod = augmented[item.productionNumber];
+            switch (item.action) {
+                case Action::ACCEPT:
+                    if (!set(endOfSentence, AscendingAction{item.action, 0})) {
+                        ECHO("[CONFLICT] ACCEPT");
+                        conflict = true;
+                    }
+                    break;
+                case Action::GOTO:
+                    table.setGoto(columnOf[prod.getProductIds()[item.position]], item.targetState);
+                    break;
+                case Action::SHIFT: {
+                    SymbolId symbol = prod.getProductIds()[item.position];
+                    if (!set(columnOf[symbol], AscendingAction{item.action, item.targetState})) {
+                        ECHO("[CONFLICT] S " + std::to_string(i) + " " + augmented.symbol(symbol));
+                        conflict = true;
+                    }
+                    break;
+                }
+                case Action::REDUCE: {
+                    AscendingAction action{item.action, item.productionNumber};
+                    lookaheads(i, j).forEach([&](SymbolId s) {
+                        if (s >= augmented.numSymbols()) {
+                            // The end of the input is an explicit terminal here
+                            return;
+                        }
+                        if (!set(columnOf[s], action)) {
+                            ECHO("[CONFLICT] R " + std::to_string(i) + " " + augmented.symbol(s));
+                            conflict = true;
+                        }
+                    });
+                    break;
+                }
+                default:
+                    ECHO("????");
+                    assert(false);
+            }
+        }
+    }
+    table.compress();
+}
+
+ParseResults parser::LRParser::parse(const std::vector<Token>& tokens) {
+    return run(tokens, nullptr);
+}
+
+ParseResults parser::LRParser::parse(const std::vector<Token>& tokens, ParseTree& tree) {
+    tree.clear();
+    return run(tokens, &tree);
+}
+
+ParseResults parser::LRParser::parse(const std::vector<SymbolId>& tokens) {
+    return run(tokens, nullptr);
+}
+
+ParseResults parser::LRParser::parse(const std::vector<SymbolId>& tokens, ParseTree& tree) {
+    tree.clear();
+    return run(tokens, &tree);
+}
+
+template<typename T>
+ParseResults parser::LRParser::run(const std::vector<T>& tokens, ParseTree* tree) {
+    assert(canParse());
+    ParseResults results;
+    stack.clear();
+    stack.push_back(0);
+    // The nodes of the stack symbols, i.e. of every state but the first
+    nodes.clear();
+    std::size_t length = tokens.size();
+    std::size_t inputPointer = 0;
+    unsigned currToken = (length > 0) ? column(tokens[0]) : endOfSentence;
+    while (true) {
+        LRTable::Entry entry = table.action(stack.back(), currToken);
+        switch (LRTable::kind(entry)) {
+            case Action::ACCEPT:
+                if (tree) {
+                    tree->setRoot(nodes.back());
+                }
+                results.accepted = true;
+                return results;
+            case Action::REDUCE: {
+                std::size_t index = LRTable::target(entry);
+                if (tree) {
+                    unsigned size = lengths[index];
+                    auto children = nodes.end() - size;
+                    std::size_t first = (size > 0) ? (*children)->token : inputPointer;
+                    ParseNode* node = tree->node(augmented[index].getNameId(), index, first, size);
+                    std::copy(children, nodes.end(), node->children);
+                    nodes.erase(children, nodes.end());
+                    nodes.push_back(node);
+                }
+                stack.resize(stack.size() - lengths[index]);
+                stack.push_back(table.go(stack.back(), names[index]));
+                break;
+            }
+            case Action::SHIFT:
+                if (tree) {
+                    nodes.push_back(tree->leaf(terminals[currToken], inputPointer));
+                }
+                stack.push_back(LRTable::target(entry));
+                inputPointer++;
+                currToken = (inputPointer < length)
+                          ? column(tokens[inputPointer])
+                          : endOfSentence;
+                break;
+            default:
+                return error(tokens, inputPointer,
+                    "Unexpected token '" + typeAt(tokens, inputPointer) + "'");
+        }
+    }
+}
+
+bool parser::LRParser::canParse() const {
+    return !conflict;
+}
+
+std::size_t parser::LRParser::numStates() const {
+    return table.size();
+}
+
+unsigned parser::LRParser::column(const Token& token) const {
+    auto it = columnByType.find(token.type);
+    return (it == columnByType.end()) ? unknown : it->second;
+}
+
+unsigned parser::LRParser::column(SymbolId symbol) const {
+    return (symbol < columnById.size()) ? columnById[symbol] : unknown;
+}
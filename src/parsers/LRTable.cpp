@@ -0,0 +1,235 @@
+/* created by Ghabriel Nunes <ghabriel.nunes@gmail.com> [2016] */
+#include <algorithm>
+#include <cassert>
+#include <unordered_map>
+#include "Lexer.hpp"
+#include "parsers/LRTable.hpp"
+
+const parser::LRTable::State parser::LRTable::none;
+const parser::LRTable::Entry parser::LRTable::error;
+const parser::Action parser::LRTable::kinds[8] = {
+    Action::UNKNOWN, Action::SHIFT, Action::REDUCE, Action::ACCEPT,
+    Action::CONFLICT, Action::UNKNOWN, Action::UNKNOWN, Action::UNKNOWN
+};
+
+namespace {
+    // Returns the most frequent value of a row, or a fallback if there's
+    // no value accepted by a filter.
+    template<typename Row, typename Filter>
+    unsigned mostFrequent(const Row& row, unsigned fallback, const Filter& filter) {
+        std::unordered_map<unsigned, std::size_t> count;
+        unsigned result = fallback;
+        std::size_t best = 0;
+        for (auto& pair : row) {
+            if (filter(pair.second) && ++count[pair.second] > best) {
+                best = count[pair.second];
+                result = pair.second;
+            }
+        }
+        return result;
+    }
+}
+
+parser::LRTable::LRTable(std::size_t numTerminals, std::size_t numNonTerminals)
+    : numTerminals(numTerminals), numNonTerminals(numNonTerminals),
+      gotoRows(numNonTerminals), current(numTerminals, 0) {}
+
+std::size_t parser::LRTable::size() const {
+    return actionRows.empty() ? defaultAction.size() : actionRows.size();
+}
+
+parser::LRTable::State parser::LRTable::addState() {
+    if (!actionRows.empty()) {
+        // Clears the positions used by the previous state
+        for (auto& pair : actionRows.back()) {
+            current[pair.first] = 0;
+        }
+    }
+    actionRows.emplace_back();
+    return actionRows.size() - 1;
+}
+
+bool parser::LRTable::setAction(unsigned terminal, const AscendingAction& action) {
+    Entry entry = encode(action);
+    Entry& value = cell(terminal);
+    if (value != error) {
+        return value == entry;
+    }
+    value = entry;
+    return true;
+}
+
+void parser::LRTable::addAction(unsigned terminal, const AscendingAction& action) {
+    Entry entry = encode(action);
+    Entry& value = cell(terminal);
+    if (value == error || value == entry) {
+        value = entry;
+        return;
+    }
+
+    if (kind(value) != Action::CONFLICT) {
+        conflictLists.push_back({value});
+        value = ((conflictLists.size() - 1) << 3) | 4;
+    }
+
+    auto& list = conflictLists[target(value)];
+    if (std::find(list.begin(), list.end(), entry) == list.end()) {
+        list.push_back(entry);
+    }
+}
+
+void parser::LRTable::setGoto(unsigned nonTerminal, State target) {
+    assert(!actionRows.empty() && nonTerminal < numNonTerminals);
+    gotoRows[nonTerminal].emplace_back(actionRows.size() - 1, target);
+}
+
+void parser::LRTable::compress() {
+    // Default reductions
+    defaultAction.resize(actionRows.size());
+    for (std::size_t i = 0; i < actionRows.size(); i++) {
+        Row& row = actionRows[i];
+        Entry fallback = mostFrequent(row, error, [](Entry entry) {
+            return kind(entry) == Action::REDUCE;
+        });
+        defaultAction[i] = fallback;
+        row.erase(std::remove_if(row.begin(), row.end(), [fallback](const std::pair<unsigned, Entry>& pair) {
+            return pair.second == fallback;
+        }), row.end());
+    }
+
+    // Default gotos
+    defaultGoto.resize(numNonTerminals);
+    for (std::size_t i = 0; i < numNonTerminals; i++) {
+        Row& row = gotoRows[i];
+        State fallback = mostFrequent(row, none, [](State) { return true; });
+        defaultGoto[i] = fallback;
+        row.erase(std::remove_if(row.begin(), row.end(), [fallback](const std::pair<unsigned, State>& pair) {
+            return pair.second == fallback;
+        }), row.end());
+    }
+
+    pack(actionRows, numTerminals, actionBase, actionCheck, actionValue);
+    pack(gotoRows, actionRows.size(), gotoBase, gotoCheck, gotoValue);
+    actionRows = std::vector<Row>();
+    gotoRows = std::vector<Row>();
+    current = std::vector<Entry>();
+}
+
+parser::AscendingAction parser::LRTable::decode(Entry entry) {
+    return AscendingAction{kind(entry), target(entry)};
+}
+
+parser::LRTable::Entry parser::LRTable::encode(const AscendingAction& action) {
+    switch (action.action) {
+        case Action::SHIFT:
+            return (action.target << 3) | 1;
+        case Action::REDUCE:
+            return (action.target << 3) | 2;
+        case Action::ACCEPT:
+            return 3;
+        default:
+            assert(false);
+            return error;
+    }
+}
+
+parser::LRTable::Entry& parser::LRTable::cell(unsigned terminal) {
+    assert(!actionRows.empty() && terminal < numTerminals);
+    Row& row = actionRows.back();
+    // current[terminal] is the position of terminal in the row plus 1
+    Entry& position = current[terminal];
+    if (position == 0) {
+        row.emplace_back(terminal, error);
+        position = row.size();
+    }
+    return row[position - 1].second;
+}
+
+void parser::LRTable::pack(const std::vector<Row>& rows, std::size_t width,
+    std::vector<std::size_t>& base, std::vector<unsigned>& check,
+    std::vector<Entry>& value) {
+
+    // Fills the densest rows first, since they're the hardest to fit
+    std::vector<std::size_t> order(rows.size());
+    for (std::size_t i = 0; i < rows.size(); i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t lhs, std::size_t rhs) {
+        return rows[lhs].size() > rows[rhs].size();
+    });
+
+    base.assign(rows.size(), 0);
+    check.clear();
+    value.clear();
+
+    // nextFree[i] leads to the first free position >= i. Positions past
+    // the end are always free.
+    std::vector<std::size_t> nextFree;
+    auto findFree = [&](std::size_t index) {
+        std::size_t root = index;
+        while (root < nextFree.size() && nextFree[root] != root) {
+            root = nextFree[root];
+        }
+        while (index < nextFree.size() && nextFree[index] != index) {
+            std::size_t next = nextFree[index];
+            nextFree[index] = root;
+            index = next;
+        }
+        return root;
+    };
+
+    for (std::size_t i : order) {
+        const Row& row = rows[i];
+        if (row.empty()) {
+            break;
+        }
+
+        unsigned minColumn = width;
+        for (auto& pair : row) {
+            minColumn = std::min(minColumn, pair.first);
+        }
+
+        // Finds the first displacement in which the row doesn't overlap
+        // the entries of previous rows. Only the displacements which put
+        // the first column in a free position are tried.
+        std::size_t offset;
+        std::size_t slot = findFree(minColumn);
+        while (true) {
+            offset = slot - minColumn;
+            bool fits = true;
+            for (auto& pair : row) {
+                std::size_t index = offset + pair.first;
+                if (index < check.size() && check[index] != none) {
+                    fits = false;
+                    break;
+                }
+            }
+            if (fits) {
+                break;
+            }
+            slot = findFree(slot + 1);
+        }
+
+        base[i] = offset;
+        if (check.size() < offset + width) {
+            std::size_t size = nextFree.size();
+            check.resize(offset + width, none);
+            value.resize(offset + width, error);
+            nextFree.resize(offset + width);
+            for (std::size_t j = size; j < nextFree.size(); j++) {
+                nextFree[j] = j;
+            }
+        }
+        for (auto& pair : row) {
+            check[offset + pair.first] = i;
+            value[offset + pair.first] = pair.second;
+            nextFree[offset + pair.first] = offset + pair.first + 1;
+        }
+    }
+
+    // Every lookup must stay in bounds, even for empty rows
+    if (check.size() < width) {
+        check.resize(width, none);
+        value.resize(width, error);
+    }
+}
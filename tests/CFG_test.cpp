@@ -315,6 +315,156 @@ TEST_F(TestCFG, Copy) {
     ASSERT_TRUE(testCopy.nullable("D"));
 }
 
+TEST_F(TestCFG, SymbolIds) {
+    cfg << "<S> ::= a<A>b|";
+    cfg << "<A> ::= <A>a|c";
+    ASSERT_EQ(5, cfg.numSymbols());
+    ASSERT_EQ(CFG::npos, cfg.id("<B>"));
+    ASSERT_EQ(CFG::npos, cfg.id("d"));
+
+    auto S = cfg.id("<S>");
+    auto A = cfg.id("<A>");
+    auto a = cfg.id("a");
+    ASSERT_NE(S, A);
+    ASSERT_EQ("<A>", cfg.symbol(A));
+    ASSERT_TRUE(cfg.isTerminal(a));
+    ASSERT_FALSE(cfg.isTerminal(S));
+    ASSERT_EQ(std::vector<std::size_t>({0, 1}), cfg.productionsOf(S));
+    ASSERT_EQ(std::vector<std::size_t>({2, 3}), cfg.productionsOf(A));
+    ASSERT_TRUE(cfg.productionsOf(a).empty());
+
+    ASSERT_EQ(std::vector<std::size_t>({a, A, cfg.id("b")}), cfg[0].getProductIds());
+    ASSERT_TRUE(cfg.firstOf(S).isSet(a));
+    ASSERT_EQ(1, cfg.firstOf(S).count());
+    ASSERT_TRUE(cfg.followOf(A).isSet(a));
+    ASSERT_TRUE(cfg.followOf(A).isSet(cfg.id("b")));
+    ASSERT_EQ(2, cfg.followOf(A).count());
+    ASSERT_TRUE(cfg.followOf(S).isSet(cfg.endOfInput()));
+    ASSERT_TRUE(cfg.nullable(S));
+    ASSERT_FALSE(cfg.nullable(A));
+    ASSERT_TRUE(cfg.endable(S));
+    ASSERT_FALSE(cfg.endable(A));
+
+    cfg.clear();
+    ASSERT_EQ(0, cfg.numSymbols());
+    ASSERT_EQ(CFG::npos, cfg.id("<S>"));
+}
+
+TEST_F(TestCFG, IncrementalAnalysis) {
+    // The analysis is updated after each production instead of being
+    // recalculated, so the results must match a fresh CFG every time.
+    std::vector<std::string> productions = {
+        "<S> ::= <A><B>c",
+        "<A> ::= a<A>",
+        "<B> ::= <C>b",
+        "<C> ::= <A><S>d",
+        "<A> ::= ",
+        "<C> ::= ",
+        "<D> ::= <B><D>e",
+        "<B> ::= <D>",
+        "<D> ::= f<E>",
+        "<E> ::= <S>",
+        "<D> ::= ",
+    };
+    CFG fresh;
+    for (auto& production : productions) {
+        cfg << production;
+        fresh.clear();
+        for (std::size_t i = 0; i < cfg.size(); i++) {
+            fresh << cfg.toReadableForm(cfg[i]);
+        }
+
+        for (auto& symbol : fresh.getNonTerminals()) {
+            EXPECT_EQ(fresh.first(symbol), cfg.first(symbol));
+            EXPECT_EQ(fresh.follow(symbol), cfg.follow(symbol));
+            EXPECT_EQ(fresh.nullable(symbol), cfg.nullable(symbol));
+            EXPECT_EQ(fresh.endable(symbol), cfg.endable(symbol));
+        }
+        EXPECT_EQ(fresh.numDependencies(), cfg.numDependencies());
+    }
+    EXPECT_EQ(set({"a", "b", "c", "e", "f"}), cfg.first("<S>"));
+    EXPECT_EQ(set({"a", "b", "c", "d", "e", "f"}), cfg.follow("<S>"));
+}
+
+TEST_F(TestCFG, IncrementalDependencies) {
+    // Making a symbol nullable relinks the productions that use it,
+    // which must only add the edges that didn't exist yet.
+    cfg << "<S> ::= <A><B><C><S>|s";
+    cfg << "<A> ::= a" << "<B> ::= b" << "<C> ::= <A><B>c";
+    cfg.numDependencies();
+    cfg << "<A> ::= " << "<B> ::= " << "<C> ::= ";
+
+    CFG fresh;
+    for (std::size_t i = 0; i < cfg.size(); i++) {
+        fresh << cfg.toReadableForm(cfg[i]);
+    }
+    std::size_t count = fresh.numDependencies();
+    EXPECT_EQ(count, cfg.numDependencies());
+
+    for (int i = 0; i < 5; i++) {
+        cfg << "<A> ::= " << "<B> ::= " << "<C> ::= ";
+        EXPECT_EQ(count, cfg.numDependencies());
+    }
+}
+
+TEST_F(TestCFG, AddById) {
+    cfg << "<S> ::= a<S>|b";
+    ASSERT_EQ(set({"a", "b"}), cfg.first("<S>"));
+
+    // Names that SimplifiedBNF would split into several terminals
+    auto start = cfg.addSymbol("<S'>", false);
+    auto end = cfg.addSymbol("'EOS'", true);
+    EXPECT_EQ(start, cfg.id("<S'>"));
+    EXPECT_EQ(end, cfg.id("'EOS'"));
+    EXPECT_TRUE(cfg.isTerminal(end));
+    EXPECT_FALSE(cfg.isTerminal(start));
+    EXPECT_EQ(end, cfg.addSymbol("'EOS'", true));
+
+    cfg.addProduction(start, {cfg.id("<S>"), end});
+    ASSERT_EQ(3u, cfg.size());
+    EXPECT_EQ(start, cfg[2].getNameId());
+    EXPECT_EQ(std::vector<CFG::SymbolId>({cfg.id("<S>"), end}), cfg[2].getProductIds());
+    EXPECT_EQ(set({"a", "b"}), cfg.first("<S'>"));
+    EXPECT_EQ(set({"'EOS'"}), cfg.follow("<S>"));
+}
+
+TEST_F(TestCFG, LargeGrammar) {
+    // Two long chains of non-terminals, through which first and follow
+    // sets must be propagated:
+    // <Ai> ::= <Ai+1>'ai' | 'bi', <An> ::= <A0>'a' | ''
+    // <Bi> ::= 'ci'<Bi+1> | 'di', <Bn> ::= <B0>'f' | ''
+    const std::size_t length = 3000;
+    auto terminal = [](const std::string& name, std::size_t i) {
+        return name + std::to_string(i);
+    };
+    auto nonTerminal = [](const std::string& name, std::size_t i) {
+        return "<" + name + std::to_string(i) + ">";
+    };
+    auto test = CFG::create(BNF());
+    test << "<S> ::= <A0><B0>'e'";
+    for (std::size_t i = 0; i < length; i++) {
+        test << nonTerminal("A", i) + " ::= " + nonTerminal("A", i + 1)
+              + "'" + terminal("a", i) + "' | '" + terminal("b", i) + "'";
+        test << nonTerminal("B", i) + " ::= '" + terminal("c", i) + "'"
+              + nonTerminal("B", i + 1) + " | '" + terminal("d", i) + "'";
+    }
+    test << nonTerminal("A", length) + " ::= <A0>'a' | ''";
+    test << nonTerminal("B", length) + " ::= <B0>'f' | ''";
+
+    auto first = test.first("<S>");
+    ASSERT_EQ(length + 1, first.size());
+    ASSERT_EQ(1, first.count(terminal("a", length - 1)));
+    ASSERT_EQ(1, first.count(terminal("b", length - 1)));
+    ASSERT_EQ(first, test.first(nonTerminal("A", length / 2)));
+    ASSERT_TRUE(test.nullable(nonTerminal("A", length)));
+    ASSERT_FALSE(test.nullable("<A0>"));
+
+    EXPECT_EQ(set({"a", "c0", "d0"}), test.follow("<A0>"));
+    EXPECT_EQ(set({"e", "f"}), test.follow(nonTerminal("B", length / 2)));
+    EXPECT_TRUE(test.endable("<S>"));
+    EXPECT_FALSE(test.endable(nonTerminal("B", length)));
+}
+
 // TEST_F(TestCFG, FactorizationElimination) {
 //     cfg << "<S> ::= a<S>b|ac";
 //     CFG expected;
@@ -107,6 +107,37 @@ TEST_F(TestDFA, ReadStress) {
     EXPECT_EQ("q4", instance.state().getName());
 }
 
+TEST_F(TestDFA, CompiledTable) {
+    instance << "q0";
+    instance << "q1";
+    instance << "q2";
+    instance.addTransition("q0", "q1", 'a');
+    instance.addTransition("q1", "q2", 'b');
+    instance.addTransition("q2", "q1", 'b');
+    instance.accept("q2");
+
+    const TransitionTable& table = instance.compile();
+    EXPECT_EQ(3, table.size());
+    EXPECT_TRUE(table.matches("ab"));
+    EXPECT_TRUE(table.matches("abbb"));
+    EXPECT_FALSE(table.matches("abb"));
+    EXPECT_FALSE(table.matches("ba"));
+    EXPECT_EQ(TransitionTable::dead, table.run("ac"));
+
+    std::vector<bool> expected = {true, false, false, true, false};
+    EXPECT_EQ(expected, instance.matchAll({"ab", "", "a", "abbbbb", "abc"}));
+    EXPECT_TRUE(instance.run("abbb"));
+    EXPECT_EQ(instance.initialState(), instance.state());
+
+    instance.addTransition("q2", "q0", 'c');
+    EXPECT_TRUE(instance.run("abcab"));
+    instance.read("abca");
+    EXPECT_EQ("q1", instance.state().getName());
+    instance.read("c");
+    EXPECT_TRUE(instance.error());
+    EXPECT_EQ("q1", instance.state().getName());
+}
+
 TEST_F(TestDFA, Size) {
     EXPECT_EQ(0, instance.size());
     instance << "q0";
@@ -136,6 +167,34 @@ TEST_F(TestDFA, Alphabet) {
     EXPECT_EQ(expected, instance.alphabet());
 }
 
+TEST_F(TestDFA, ByteClasses) {
+    instance << "q0";
+    instance << "q1";
+    instance << "q2";
+    for (char c = '0'; c <= '9'; c++) {
+        instance.addTransition("q0", "q1", c);
+        instance.addTransition("q1", "q1", c);
+    }
+    instance.addTransition("q0", "q2", '-');
+    instance.addTransition("q2", "q1", '5');
+    instance.accept("q1");
+
+    auto& classes = instance.classes();
+    EXPECT_EQ(classes['0'], classes['9']);
+    EXPECT_EQ(classes['1'], classes['4']);
+    EXPECT_NE(classes['0'], classes['5']);
+    EXPECT_NE(classes['0'], classes['-']);
+    EXPECT_NE(classes['0'], classes['x']);
+    EXPECT_EQ(classes['x'], classes['+']);
+    EXPECT_EQ(4, classes.size());
+    EXPECT_EQ(4, instance.compile().columns());
+
+    EXPECT_TRUE(instance.run("-5"));
+    EXPECT_TRUE(instance.run("-50"));
+    EXPECT_FALSE(instance.run("-4"));
+    EXPECT_TRUE(instance.run("42"));
+}
+
 TEST_F(TestDFA, AcceptingStates) {
     instance << "q0";
     instance << "q1";
@@ -332,6 +391,37 @@ TEST_F(TestDFA, MinimizationStress) {
     EXPECT_EQ((limit + 1)/2, other.size());
 }
 
+TEST_F(TestDFA, MinimizationCycle) {
+    auto fn = [](unsigned i) -> std::string {
+        return std::to_string(i);
+    };
+
+    // A cycle of 3 * 10^4 states counting 'a's modulo 3, where 'b'
+    // resets the count. Only 3 states are distinguishable.
+    unsigned limit = 3e4;
+    instance.reserve(limit);
+    for (unsigned i = 0; i < limit; i++) {
+        instance << ("q" + fn(i));
+        if (i % 3 == 0) {
+            instance.accept("q" + fn(i));
+        }
+    }
+    for (unsigned i = 0; i < limit; i++) {
+        instance.addTransition("q" + fn(i), "q" + fn((i + 1) % limit), 'a');
+        instance.addTransition("q" + fn(i), "q" + fn((i / 3) * 3), 'b');
+    }
+
+    DFA other;
+    ASSERT_NO_THROW(other = instance.minimized());
+    EXPECT_EQ(3, other.size());
+    EXPECT_EQ("q0", other.initialState().getName());
+    EXPECT_TRUE(other.run("aaa"));
+    EXPECT_TRUE(other.run("aab"));
+    EXPECT_FALSE(other.run("ba"));
+    EXPECT_FALSE(other.run("aaaaa"));
+    EXPECT_TRUE(other.run("aaaaab"));
+}
+
 TEST_F(TestDFA, Complement) {
     instance << "q0";
     instance << "q1";
@@ -0,0 +1,140 @@
+/* created by Ghabriel Nunes <ghabriel.nunes@gmail.com> [2016] */
+
+#include <gtest/gtest.h>
+#include <random>
+#include "Lexer.hpp"
+#include "parsers/LRTable.hpp"
+
+using parser::Action;
+using parser::AscendingAction;
+using parser::LRTable;
+
+namespace {
+    const std::size_t numTerminals = 23;
+    const std::size_t numNonTerminals = 11;
+    const std::size_t numStates = 300;
+}
+
+class TestLRTable : public ::testing::Test {
+protected:
+    std::mt19937 random{42};
+    LRTable table{numTerminals, numNonTerminals};
+    // Explicit actions and gotos of each state, or UNKNOWN/none
+    std::vector<std::vector<AscendingAction>> actions;
+    std::vector<std::vector<LRTable::State>> gotos;
+
+    void fill(std::size_t density) {
+        for (std::size_t state = 0; state < numStates; state++) {
+            table.addState();
+            actions.emplace_back(numTerminals);
+            gotos.emplace_back(numNonTerminals, LRTable::none);
+            for (unsigned terminal = 0; terminal < numTerminals; terminal++) {
+                if (random() % 100 >= density) {
+                    continue;
+                }
+                // Few distinct reductions, so default reductions are used
+                AscendingAction action;
+                switch (random() % 3) {
+                    case 0:
+                        action = AscendingAction{Action::SHIFT, random() % numStates};
+                        break;
+                    case 1:
+                        action = AscendingAction{Action::REDUCE, random() % 3};
+                        break;
+                    default:
+                        action = AscendingAction{Action::REDUCE, random() % 40};
+                }
+                ASSERT_TRUE(table.setAction(terminal, action));
+                actions[state][terminal] = action;
+            }
+            for (unsigned nonTerminal = 0; nonTerminal < numNonTerminals; nonTerminal++) {
+                if (random() % 100 < density) {
+                    LRTable::State target = random() % 5;
+                    table.setGoto(nonTerminal, target);
+                    gotos[state][nonTerminal] = target;
+                }
+            }
+        }
+        table.compress();
+    }
+
+    void check() {
+        ASSERT_EQ(numStates, table.size());
+        for (LRTable::State state = 0; state < numStates; state++) {
+            // Cells without an action either are errors or use the
+            // default reduction, which must be the same for all of them
+            LRTable::Entry fallback = LRTable::error;
+            bool first = true;
+            for (unsigned terminal = 0; terminal < numTerminals; terminal++) {
+                const AscendingAction& expected = actions[state][terminal];
+                LRTable::Entry entry = table.action(state, terminal);
+                if (expected.action != Action::UNKNOWN) {
+                    AscendingAction action = LRTable::decode(entry);
+                    EXPECT_EQ(expected.action, action.action);
+                    EXPECT_EQ(expected.target, action.target);
+                    continue;
+                }
+
+                if (first) {
+                    fallback = entry;
+                    first = false;
+                }
+                EXPECT_EQ(fallback, entry);
+                if (entry != LRTable::error) {
+                    EXPECT_EQ(Action::REDUCE, LRTable::kind(entry));
+                }
+            }
+
+            for (unsigned nonTerminal = 0; nonTerminal < numNonTerminals; nonTerminal++) {
+                if (gotos[state][nonTerminal] != LRTable::none) {
+                    EXPECT_EQ(gotos[state][nonTerminal], table.go(state, nonTerminal));
+                }
+            }
+        }
+    }
+};
+
+TEST_F(TestLRTable, SparseRoundTrip) {
+    fill(10);
+    check();
+}
+
+TEST_F(TestLRTable, DenseRoundTrip) {
+    fill(70);
+    check();
+}
+
+TEST_F(TestLRTable, Conflicts) {
+    LRTable table(3, 1);
+    table.addState();
+    EXPECT_TRUE(table.setAction(0, {Action::SHIFT, 1}));
+    EXPECT_TRUE(table.setAction(0, {Action::SHIFT, 1}));
+    EXPECT_FALSE(table.setAction(0, {Action::REDUCE, 2}));
+    EXPECT_TRUE(table.setAction(2, {Action::ACCEPT, 0}));
+
+    table.addState();
+    table.addAction(1, {Action::SHIFT, 0});
+    table.addAction(1, {Action::REDUCE, 3});
+    table.addAction(1, {Action::REDUCE, 3});
+    table.addAction(1, {Action::REDUCE, 4});
+    table.compress();
+
+    EXPECT_EQ(Action::SHIFT, LRTable::kind(table.action(0, 0)));
+    EXPECT_EQ(1u, LRTable::target(table.action(0, 0)));
+    EXPECT_EQ(Action::ACCEPT, LRTable::kind(table.action(0, 2)));
+    EXPECT_EQ(LRTable::error, table.action(0, 1));
+
+    LRTable::Entry entry = table.action(1, 1);
+    ASSERT_EQ(Action::CONFLICT, LRTable::kind(entry));
+    const auto& list = table.conflicts(entry);
+    ASSERT_EQ(3u, list.size());
+    EXPECT_EQ(Action::SHIFT, LRTable::kind(list[0]));
+    EXPECT_EQ(Action::REDUCE, LRTable::kind(list[1]));
+    EXPECT_EQ(3u, LRTable::target(list[1]));
+    EXPECT_EQ(4u, LRTable::target(list[2]));
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
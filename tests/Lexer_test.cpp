@@ -1,6 +1,9 @@
 /* created by Ghabriel Nunes <ghabriel.nunes@gmail.com> [2016] */
 
 #include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
 #include "Lexer.hpp"
 
 class TestLexer : public ::testing::Test {
@@ -71,6 +74,233 @@ TEST_F(TestLexer, Test2) {
     EXPECT_EQ(expected, tokens);
 }
 
+TEST_F(TestLexer, RegistrationOrder) {
+    lexer.addToken("IF", "if");
+    lexer.addToken("IDENTIFIER", "[a-z]+");
+    lexer.addToken("ELSE", "else");
+    lexer.ignore(' ');
+    lexer.addDelimiters(" ");
+
+    std::vector<Token> tokens = lexer.read("if else iffy");
+    ASSERT_TRUE(lexer.accepts());
+
+    std::vector<Token> expected;
+    expected.push_back({"IF", "if"});
+    expected.push_back({"IDENTIFIER", "else"});
+    expected.push_back({"IDENTIFIER", "iffy"});
+    EXPECT_EQ(expected, tokens);
+
+    lexer.removeToken("IDENTIFIER");
+    tokens = lexer.read("if else");
+    ASSERT_TRUE(lexer.accepts());
+    expected = {{"IF", "if"}, {"ELSE", "else"}};
+    EXPECT_EQ(expected, tokens);
+
+    lexer.read("iffy");
+    EXPECT_FALSE(lexer.accepts());
+
+    // Removing an unknown type doesn't give it an id
+    lexer.removeToken("UNKNOWN");
+    lexer.addToken("THEN", "then");
+    EXPECT_EQ(3u, lexer.tokenId("THEN"));
+    EXPECT_EQ("THEN", lexer.typeName(3));
+}
+
+TEST_F(TestLexer, Priorities) {
+    lexer.addToken("IDENTIFIER", "[a-z]+");
+    lexer.addToken("IF", "if", 1);
+    lexer.addToken("ELSE", "else", 1);
+    lexer.addToken("HEX", "[0-9a-f]+", -1);
+    lexer.addToken("NUMBER", "[0-9]+", -1);
+    lexer.ignore(' ');
+    lexer.addDelimiters(" ");
+
+    std::vector<Token> tokens = lexer.read("if else iffy cafe 42");
+    ASSERT_TRUE(lexer.accepts());
+
+    std::vector<Token> expected;
+    expected.push_back({"IF", "if"});
+    expected.push_back({"ELSE", "else"});
+    expected.push_back({"IDENTIFIER", "iffy"});
+    expected.push_back({"IDENTIFIER", "cafe"});
+    expected.push_back({"HEX", "42"});
+    EXPECT_EQ(expected, tokens);
+}
+
+TEST_F(TestLexer, Spans) {
+    lexer.addToken("NUMBER", "[0-9]+");
+    lexer.addToken("PLUS", "\\+");
+    lexer.ignore(' ');
+    lexer.addDelimiters("[^0-9]");
+
+    std::string input = "  12 + 3 4+";
+    auto spans = lexer.scan(input);
+    ASSERT_TRUE(lexer.accepts());
+
+    auto number = lexer.tokenId("NUMBER");
+    auto plus = lexer.tokenId("PLUS");
+    std::vector<TokenSpan> expected = {
+        {number, 2, 2}, {plus, 5, 1}, {number, 7, 1}, {number, 9, 1}, {plus, 10, 1}
+    };
+    EXPECT_EQ(expected, spans);
+    EXPECT_EQ("NUMBER", lexer.typeName(spans[0].type));
+    EXPECT_EQ("12", lexer.content(spans[0], input));
+    EXPECT_EQ((Token{"PLUS", "+"}), lexer.materialize(spans[1], input));
+
+    lexer.scan("1 x");
+    EXPECT_FALSE(lexer.accepts());
+    EXPECT_EQ("Unknown symbol 'x'", lexer.getError());
+}
+
+TEST_F(TestLexer, Stream) {
+    lexer.addToken("TYPE", "int|float");
+    lexer.addToken("EQUAL", "=");
+    lexer.addToken(";", ";");
+    lexer.addToken("NUMBER", "[0-9]+\\.?[0-9]*|\\.[0-9]+");
+    lexer.addToken("IDENTIFIER", "[A-Za-z_][A-Za-z0-9_]*");
+    lexer.ignore(' ');
+    lexer.ignore('\n');
+    lexer.addDelimiters("[^A-Za-z0-9_.]");
+
+    std::string input;
+    for (unsigned i = 0; i < 50; i++) {
+        input += "int value" + std::to_string(i) + " = " + std::to_string(i * 7) + ".5;\n";
+    }
+    auto expected = lexer.scan(input);
+    ASSERT_TRUE(lexer.accepts());
+
+    for (std::size_t chunkSize : {1, 2, 3, 7, 64, 100000}) {
+        std::vector<TokenSpan> tokens;
+        Lexer::Stream stream(lexer, [&](const TokenSpan& token, const std::string& content) {
+            EXPECT_EQ(lexer.content(token, input), content);
+            tokens.push_back(token);
+        });
+        for (std::size_t i = 0; i < input.size(); i += chunkSize) {
+            stream.feed(input.substr(i, chunkSize));
+        }
+        stream.finish();
+        ASSERT_TRUE(stream.accepts());
+        EXPECT_EQ(expected, tokens) << chunkSize;
+    }
+
+    std::istringstream file(input);
+    std::size_t count = 0;
+    Lexer::Stream stream(lexer, [&](const TokenSpan&, const std::string&) {
+        count++;
+    });
+    stream.feed(file, 5);
+    stream.finish();
+    EXPECT_EQ(expected.size(), count);
+
+    Lexer::Stream invalid(lexer, [](const TokenSpan&, const std::string&) {});
+    invalid.feed("int x = 1");
+    invalid.feed("; $");
+    invalid.finish();
+    EXPECT_FALSE(invalid.accepts());
+}
+
+TEST_F(TestLexer, MappedFile) {
+    lexer.addToken("NUMBER", "[0-9]+");
+    lexer.addToken("WORD", "[a-z]+");
+    lexer.ignore(' ');
+    lexer.ignore('\n');
+    lexer.addDelimiters({' ', '\n'});
+
+    std::string input = "abc 12\nde 3\n";
+    std::string path = "Lexer_test.tmp";
+    std::ofstream(path) << input;
+    {
+        MappedFile file(path);
+        ASSERT_TRUE(file.isOpen());
+        ASSERT_EQ(input.size(), file.size());
+
+        auto tokens = lexer.scan(file);
+        ASSERT_TRUE(lexer.accepts());
+        EXPECT_EQ(lexer.scan(input), tokens);
+        ASSERT_EQ(4, tokens.size());
+        EXPECT_EQ("de", lexer.content(tokens[2], file));
+        EXPECT_EQ(file.data() + 7, file.data() + tokens[2].offset);
+    }
+    std::remove(path.c_str());
+
+    MappedFile missing(path);
+    EXPECT_FALSE(missing.isOpen());
+    EXPECT_TRUE(lexer.scan(missing).empty());
+    EXPECT_FALSE(lexer.accepts());
+}
+
+TEST_F(TestLexer, LinearMaximalMunch) {
+    // Each token is found only after reading the rest of the input,
+    // which used to make lexing quadratic (about 10^10 steps here)
+    lexer.addToken("A", "a");
+    lexer.addToken("AB", "a*b");
+    lexer.addToken("C", "c");
+    lexer.addToken("CD", "(c|x)*d");
+
+    std::size_t length = 200000;
+    std::string input(length, 'a');
+    auto tokens = lexer.scan(input);
+    ASSERT_TRUE(lexer.accepts());
+    ASSERT_EQ(length, tokens.size());
+    EXPECT_EQ(lexer.tokenId("A"), tokens.back().type);
+
+    input = std::string(length, 'c') + "xd";
+    tokens = lexer.scan(input);
+    ASSERT_TRUE(lexer.accepts());
+    ASSERT_EQ(1, tokens.size());
+    EXPECT_EQ((TokenSpan{lexer.tokenId("CD"), 0, length + 2}), tokens[0]);
+
+    input = std::string(length, 'c') + "xx";
+    tokens = lexer.scan(input);
+    ASSERT_FALSE(lexer.accepts());
+    ASSERT_EQ(length, tokens.size());
+
+    std::size_t count = 0;
+    Lexer::Stream stream(lexer, [&](const TokenSpan&, const std::string&) {
+        count++;
+    });
+    for (std::size_t i = 0; i < length; i += 1000) {
+        stream.feed(std::string(1000, 'c'));
+    }
+    stream.finish();
+    ASSERT_TRUE(stream.accepts());
+    EXPECT_EQ(length, count);
+}
+
+TEST_F(TestLexer, Parallel) {
+    lexer.addToken("TYPE", "int|float");
+    lexer.addToken("EQUAL", "=");
+    lexer.addToken(";", ";");
+    lexer.addToken("NUMBER", "[0-9]+\\.?[0-9]*|\\.[0-9]+");
+    lexer.addToken("IDENTIFIER", "[A-Za-z_][A-Za-z0-9_]*");
+    lexer.ignore(' ');
+    lexer.ignore('\n');
+    lexer.addDelimiters("[^A-Za-z0-9_.]");
+
+    // Runs of ignored delimiters make some chunks guess wrong
+    std::string input;
+    for (unsigned i = 0; input.size() < 600000; i++) {
+        input += "int value" + std::to_string(i) + std::string(i % 5, ' ') + "= ";
+        input += std::to_string(i * 7) + "  ;\n\n  float x = .5;\n";
+    }
+    auto expected = lexer.scan(input);
+    ASSERT_TRUE(lexer.accepts());
+
+    for (unsigned threads : {1, 2, 3, 8}) {
+        EXPECT_EQ(expected, lexer.scanParallel(input, threads)) << threads;
+        EXPECT_TRUE(lexer.accepts());
+    }
+
+    input[input.size() / 2] = '$';
+    expected = lexer.scan(input);
+    ASSERT_FALSE(lexer.accepts());
+    std::string error = lexer.getError();
+    for (unsigned threads : {2, 3, 8}) {
+        EXPECT_EQ(expected, lexer.scanParallel(input, threads)) << threads;
+        EXPECT_EQ(error, lexer.getError());
+    }
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
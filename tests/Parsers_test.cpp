@@ -0,0 +1,753 @@
+/* created by Ghabriel Nunes <ghabriel.nunes@gmail.com> [2016] */
+
+#include <gtest/gtest.h>
+#include <set>
+#include "CFG.hpp"
+#include "Lexer.hpp"
+#include "parsers/Earley.hpp"
+#include "parsers/GLR.hpp"
+#include "parsers/LALR1.hpp"
+#include "parsers/LL1.hpp"
+#include "parsers/LR1.hpp"
+#include "parsers/SLR1.hpp"
+#include "representations/DidacticNotation.hpp"
+
+class TestParsers : public ::testing::Test {
+protected:
+    CFG cfg;
+
+    // Returns one token per character, whose type is the character itself.
+    static std::vector<Token> tokens(const std::string& input) {
+        std::vector<Token> result;
+        for (char c : input) {
+            result.push_back({std::string(1, c), std::string(1, c)});
+        }
+        return result;
+    }
+
+    // Returns a tree as symbol, production and first token of each node,
+    // followed by its children.
+    std::string render(const ParseNode* node) const {
+        std::string result;
+        render(node, result);
+        return result;
+    }
+
+    void render(const ParseNode* node, std::string& result) const {
+        result += cfg.symbol(node->symbol);
+        if (node->production != ParseNode::leaf) {
+            result += std::to_string(node->production);
+        }
+        result += "@" + std::to_string(node->token);
+        if (node->production == ParseNode::leaf) {
+            EXPECT_EQ(0u, node->numChildren);
+            return;
+        }
+        result += "(";
+        for (unsigned i = 0; i < node->numChildren; i++) {
+            result += (i > 0) ? " " : "";
+            render(node->children[i], result);
+        }
+        result += ")";
+    }
+
+    // Returns the number of trees of a node of a GLR forest.
+    static std::size_t countTrees(const parser::GLR& parser, std::size_t node,
+        std::vector<std::size_t>& memo) {
+
+        const auto& forestNode = parser.forest()[node];
+        if (forestNode.symbol == CFG::npos) {
+            return 1;
+        }
+        if (memo[node] == 0) {
+            for (std::size_t i = forestNode.firstAlternative; i != parser::GLR::none;
+                i = parser.packedNodes()[i].next) {
+
+                const auto& packed = parser.packedNodes()[i];
+                std::size_t count = 1;
+                for (std::size_t j = packed.childrenBegin; j < packed.childrenEnd; j++) {
+                    count *= countTrees(parser, parser.children()[j], memo);
+                }
+                memo[node] += count;
+            }
+        }
+        return memo[node];
+    }
+
+    static std::size_t countTrees(const parser::GLR& parser) {
+        std::vector<std::size_t> memo(parser.forest().size(), 0);
+        return countTrees(parser, parser.root(), memo);
+    }
+
+    // Returns an input made of copies of a sentence, without its last token.
+    static std::vector<Token> repeat(const std::string& sentence, std::size_t copies) {
+        std::vector<Token> result;
+        for (std::size_t i = 0; i < copies; i++) {
+            auto part = tokens(sentence);
+            result.insert(result.end(), part.begin(), part.end());
+        }
+        result.pop_back();
+        return result;
+    }
+
+    // Checks that the work counted by a parser grows linearly with the
+    // length of the input. Quadratic work would grow 16 times from the
+    // smaller input to the larger one.
+    template<typename P>
+    static void expectLinear(P& parser, std::size_t (P::*work)() const,
+        const std::string& sentence) {
+
+        const std::size_t copies = 1000;
+        ASSERT_TRUE(parser.parse(repeat(sentence, copies)).accepted);
+        std::size_t small = (parser.*work)();
+        ASSERT_TRUE(parser.parse(repeat(sentence, 4 * copies)).accepted);
+        std::size_t large = (parser.*work)();
+        EXPECT_LE(large, 4 * small + 100);
+    }
+};
+
+TEST_F(TestParsers, LL1) {
+    cfg << "<E> ::= <T><E1>";
+    cfg << "<E1> ::= +<T><E1>|";
+    cfg << "<T> ::= <F><T1>";
+    cfg << "<T1> ::= *<F><T1>|";
+    cfg << "<F> ::= (<E>)|i";
+    parser::LL1 parser(cfg);
+    ASSERT_TRUE(parser.canParse());
+    EXPECT_TRUE(parser.parse(tokens("i")).accepted);
+    EXPECT_TRUE(parser.parse(tokens("i+i*i")).accepted);
+    EXPECT_TRUE(parser.parse(tokens("(i+i)*(i)")).accepted);
+    EXPECT_TRUE(parser.parse(tokens("((i))")).accepted);
+
+    ParseResults results = parser.parse(tokens(""));
+    EXPECT_FALSE(results.accepted);
+    EXPECT_EQ(0u, results.errorIndex);
+
+    results = parser.parse(tokens("i+"));
+    EXPECT_FALSE(results.accepted);
+    EXPECT_EQ(2u, results.errorIndex);
+
+    results = parser.parse(tokens("(i+i"));
+    EXPECT_FALSE(results.accepted);
+    EXPECT_EQ(4u, results.errorIndex);
+
+    results = parser.parse(tokens("i)"));
+    EXPECT_FALSE(results.accepted);
+    EXPECT_EQ(1u, results.errorIndex);
+
+    // Unknown token types
+    results = parser.parse(tokens("i+x"));
+    EXPECT_FALSE(results.accepted);
+    EXPECT_EQ(2u, results.errorIndex);
+    EXPECT_NE(std::string::npos, results.errorMessage.find("Unexpected token 'x'"));
+    EXPECT_FALSE(parser.parse({{"<E>", "E"}}).accepted);
+}
+
+TEST_F(TestParsers, LL1EmptyProductions) {
+    cfg << "<S> ::= <A><B>c";
+    cfg << "<A> ::= a<A>|";
+    cfg << "<B> ::= b|";
+    parser::LL1 parser(cfg);
+    ASSERT_TRUE(parser.canParse());
+    EXPECT_TRUE(parser.parse(tokens("c")).accepted);
+    EXPECT_TRUE(parser.parse(tokens("aac")).accepted);
+    EXPECT_TRUE(parser.parse(tokens("bc")).accepted);
+    EXPECT_TRUE(parser.parse(tokens("abc")).accepted);
+    EXPECT_FALSE(parser.parse(tokens("bac")).accepted);
+    EXPECT_FALSE(parser.parse(tokens("ab")).accepted);
+
+    ParseResults results = parser.parse(tokens("abbc"));
+    EXPECT_FALSE(results.accepted);
+    EXPECT_EQ(2u, results.errorIndex);
+    EXPECT_NE(std::string::npos, results.errorMessage.find("expected 'c'"));
+
+    cfg.clear();
+    cfg << "<S> ::= <A>|";
+    cfg << "<A> ::= a<S>";
+    parser::LL1 nullable(cfg);
+    ASSERT_TRUE(nullable.canParse());
+    EXPECT_TRUE(nullable.parse(tokens("")).accepted);
+    EXPECT_TRUE(nullable.parse(tokens("aaa")).accepted);
+    EXPECT_FALSE(nullable.parse(tokens("ab")).accepted);
+}
+
+TEST_F(TestParsers, LL1Conflicts) {
+    cfg << "<E> ::= <E>+i|i";
+    EXPECT_FALSE(parser::LL1(cfg).canParse());
+
+    cfg.clear();
+    cfg << "<S> ::= a<A>|ab";
+    cfg << "<A> ::= b";
+    EXPECT_FALSE(parser::LL1(cfg).canParse());
+
+    cfg.clear();
+    cfg << "<S> ::= <A>a";
+    cfg << "<A> ::= a|";
+    EXPECT_FALSE(parser::LL1(cfg).canParse());
+}
+
+TEST_F(TestParsers, LL1TerminalIds) {
+    cfg << "<E> ::= <T><E1>";
+    cfg << "<E1> ::= +<T><E1>|";
+    cfg << "<T> ::= <F><T1>";
+    cfg << "<T1> ::= *<F><T1>|";
+    cfg << "<F> ::= (<E>)|i";
+    parser::LL1 parser(cfg);
+
+    Lexer lexer;
+    lexer.addToken("-", "-");
+    lexer.addToken("i", "[a-z]+");
+    lexer.addToken("+", "\\+");
+    lexer.addToken("*", "\\*");
+    lexer.addToken("(", "\\(");
+    lexer.addToken(")", "\\)");
+    lexer.ignore(' ');
+    lexer.addDelimiters(" ");
+    auto ids = parser.terminalIds(lexer.scan("x + y * ( z )"), lexer);
+    ASSERT_EQ(7u, ids.size());
+    EXPECT_EQ(cfg.id("i"), ids[0]);
+    EXPECT_EQ(cfg.id("+"), ids[1]);
+    EXPECT_TRUE(parser.parse(ids).accepted);
+
+    ParseTree tree;
+    ASSERT_TRUE(parser.parse(tokens("i+i*(i)"), tree).accepted);
+    std::string expected = render(tree.root());
+    ASSERT_TRUE(parser.parse(ids, tree).accepted);
+    EXPECT_EQ(expected, render(tree.root()));
+
+    // Types that aren't terminals of the CFG are unknown
+    ids = parser.terminalIds(lexer.scan("x - y"), lexer);
+    EXPECT_EQ(CFG::npos, ids[1]);
+    ParseResults results = parser.parse(ids);
+    EXPECT_FALSE(results.accepted);
+    EXPECT_EQ(1u, results.errorIndex);
+    ids = {cfg.id("i"), cfg.id("<E>")};
+    EXPECT_EQ(1u, parser.parse(ids).errorIndex);
+
+    results = parser.parse(std::vector<CFG::SymbolId>{cfg.id("i"), cfg.id("+")});
+    EXPECT_FALSE(results.accepted);
+    EXPECT_EQ(2u, results.errorIndex);
+    EXPECT_NE(std::string::npos, results.errorMessage.find("i +"));
+}
+
+TEST_F(TestParsers, SLR1DefaultRepresentation) {
+    cfg << "<S> ::= a<S>b|ab";
+    parser::SLR1 parser(cfg);
+    ASSERT_TRUE(parser.canParse());
+    EXPECT_TRUE(parser.parse(tokens("ab")).accepted);
+    EXPECT_TRUE(parser.parse(tokens("aaabbb")).accepted);
+    EXPECT_FALSE(parser.parse(tokens("")).accepted);
+    EXPECT_FALSE(parser.parse(tokens("aab")).accepted);
+    EXPECT_EQ(2u, parser.parse(tokens("abab")).errorIndex);
+}
+
+TEST_F(TestParsers, SLR1EndMarkerNames) {
+    // Symbols named like the ones added by the augmentation
+    cfg << "<S'> ::= E<S'>|EOS";
+    parser::SLR1 parser(cfg);
+    ASSERT_TRUE(parser.canParse());
+    EXPECT_TRUE(parser.parse(tokens("EOS")).accepted);
+    EXPECT_TRUE(parser.parse(tokens("EEOS")).accepted);
+    EXPECT_FALSE(parser.parse(tokens("EO")).accepted);
+
+    auto didactic = CFG::create(DidacticNotation());
+    didactic << "EOS -> a EOS b | a b";
+    parser::SLR1 other(didactic);
+    ASSERT_TRUE(other.canParse());
+    EXPECT_TRUE(other.parse(tokens("aabb")).accepted);
+    EXPECT_FALSE(other.parse(tokens("aab")).accepted);
+
+    // Errors at the end of the input name the actual end marker
+    ParseResults results = other.parse(tokens("a"));
+    EXPECT_EQ(1u, results.errorIndex);
+    EXPECT_NE(std::string::npos, results.errorMessage.find("Unexpected token 'EOS''"));
+}
+
+TEST_F(TestParsers, SLR1TerminalIds) {
+    cfg << "<E> ::= <E>+<T>|<T>";
+    cfg << "<T> ::= <T>*<F>|<F>";
+    cfg << "<F> ::= (<E>)|i";
+    parser::SLR1 parser(cfg);
+    auto i = cfg.id("i");
+    auto plus = cfg.id("+");
+    auto times = cfg.id("*");
+    std::vector<CFG::SymbolId> ids = {i, plus, i, times, i};
+
+    ParseTree tree;
+    ASSERT_TRUE(parser.parse(tokens("i+i*i"), tree).accepted);
+    std::string expected = render(tree.root());
+    ASSERT_TRUE(parser.parse(ids, tree).accepted);
+    EXPECT_EQ(expected, render(tree.root()));
+    EXPECT_TRUE(parser.parse(ids).accepted);
+
+    // Non-terminals and the symbols of the augmented grammar are unknown
+    ids = {i, plus, cfg.id("<T>")};
+    EXPECT_EQ(2u, parser.parse(ids).errorIndex);
+    ids = {i, cfg.numSymbols()};
+    EXPECT_EQ(1u, parser.parse(ids).errorIndex);
+    ids = {i, CFG::npos};
+    EXPECT_EQ(1u, parser.parse(ids).errorIndex);
+    ids = {i, plus};
+    EXPECT_EQ(2u, parser.parse(ids).errorIndex);
+}
+
+TEST_F(TestParsers, LR0States) {
+    cfg << "<E> ::= <E>+<T>|<T>";
+    cfg << "<T> ::= <T>*<F>|<F>";
+    cfg << "<F> ::= (<E>)|i";
+    EXPECT_EQ(12u, parser::LR0(cfg).size());
+
+    // The states after p and q reach the same kernel through c, but
+    // their items come in different orders
+    cfg.clear();
+    cfg << "<S> ::= p<A>|q<B>";
+    cfg << "<A> ::= <C>|<D>";
+    cfg << "<B> ::= <D>|<C>";
+    cfg << "<C> ::= c";
+    cfg << "<D> ::= cd";
+    auto states = parser::LR0(cfg);
+    EXPECT_EQ(12u, states.size());
+
+    std::set<std::set<std::pair<std::size_t, std::size_t>>> kernels;
+    for (auto& state : states) {
+        std::set<std::pair<std::size_t, std::size_t>> kernel;
+        for (auto& item : state.kernel) {
+            kernel.insert({item.productionNumber, item.position});
+        }
+        EXPECT_TRUE(kernels.insert(kernel).second);
+    }
+
+    // Both <C> ::= .c items shift to the same state
+    std::vector<std::size_t> targets;
+    for (auto& state : states) {
+        for (auto& item : state.items) {
+            if (item.productionNumber == 6 && item.position == 0) {
+                EXPECT_EQ(parser::Action::SHIFT, item.action);
+                targets.push_back(item.targetState);
+            }
+        }
+    }
+    ASSERT_EQ(2u, targets.size());
+    EXPECT_EQ(targets[0], targets[1]);
+}
+
+TEST_F(TestParsers, LALR1NotSLR1) {
+    cfg << "<S> ::= <L>=<R>|<R>";
+    cfg << "<L> ::= *<R>|i";
+    cfg << "<R> ::= <L>";
+    EXPECT_FALSE(parser::SLR1(cfg).canParse());
+
+    parser::LALR1 parser(cfg);
+    ASSERT_TRUE(parser.canParse());
+    EXPECT_TRUE(parser.parse(tokens("i")).accepted);
+    EXPECT_TRUE(parser.parse(tokens("i=i")).accepted);
+    EXPECT_TRUE(parser.parse(tokens("*i=**i")).accepted);
+    EXPECT_TRUE(parser.parse(tokens("***i")).accepted);
+    EXPECT_FALSE(parser.parse(tokens("")).accepted);
+    EXPECT_FALSE(parser.parse(tokens("i=")).accepted);
+
+    ParseResults results = parser.parse(tokens("i=i=i"));
+    EXPECT_FALSE(results.accepted);
+    EXPECT_EQ(3u, results.errorIndex);
+
+    results = parser.parse(tokens("=i"));
+    EXPECT_FALSE(results.accepted);
+    EXPECT_EQ(0u, results.errorIndex);
+}
+
+TEST_F(TestParsers, LALR1NullableReads) {
+    // The lookaheads of the empty reductions are read through the other
+    // nullable symbol, which SLR1 merges into a single follow set
+    cfg << "<S> ::= <A>a<A>b|<B>b<B>a";
+    cfg << "<A> ::= ";
+    cfg << "<B> ::= ";
+    EXPECT_FALSE(parser::SLR1(cfg).canParse());
+
+    parser::LALR1 parser(cfg);
+    ASSERT_TRUE(parser.canParse());
+    EXPECT_TRUE(parser.parse(tokens("ab")).accepted);
+    EXPECT_TRUE(parser.parse(tokens("ba")).accepted);
+    EXPECT_FALSE(parser.parse(tokens("aa")).accepted);
+    EXPECT_FALSE(parser.parse(tokens("a")).accepted);
+    EXPECT_FALSE(parser.parse(tokens("")).accepted);
+}
+
+TEST_F(TestParsers, LALR1NullableIncludes) {
+    // <T> ends <A>, so its lookaheads come from the ones of <A> in each
+    // state through the includes relation, and only c follows it after a
+    cfg << "<S> ::= a<A>c|b<A>d|a<B>d";
+    cfg << "<A> ::= e<T>";
+    cfg << "<B> ::= e";
+    cfg << "<T> ::= t|";
+    EXPECT_FALSE(parser::SLR1(cfg).canParse());
+
+    parser::LALR1 parser(cfg);
+    ASSERT_TRUE(parser.canParse());
+    EXPECT_TRUE(parser.parse(tokens("aec")).accepted);
+    EXPECT_TRUE(parser.parse(tokens("aetc")).accepted);
+    EXPECT_TRUE(parser.parse(tokens("aed")).accepted);
+    EXPECT_TRUE(parser.parse(tokens("bed")).accepted);
+    EXPECT_TRUE(parser.parse(tokens("betd")).accepted);
+    EXPECT_FALSE(parser.parse(tokens("aetd")).accepted);
+    EXPECT_FALSE(parser.parse(tokens("bec")).accepted);
+
+    ParseResults results = parser.parse(tokens("betc"));
+    EXPECT_FALSE(results.accepted);
+    EXPECT_EQ(3u, results.errorIndex);
+}
+
+TEST_F(TestParsers, LR1NotLALR1) {
+    cfg << "<S> ::= a<A>d|b<B>d|a<B>e|b<A>e";
+    cfg << "<A> ::= c";
+    cfg << "<B> ::= c";
+    parser::LALR1 lalr(cfg);
+    EXPECT_FALSE(lalr.canParse());
+
+    parser::LR1 parser(cfg);
+    ASSERT_TRUE(parser.canParse());
+    EXPECT_TRUE(parser.parse(tokens("acd")).accepted);
+    EXPECT_TRUE(parser.parse(tokens("bcd")).accepted);
+    EXPECT_TRUE(parser.parse(tokens("ace")).accepted);
+    EXPECT_TRUE(parser.parse(tokens("bce")).accepted);
+    EXPECT_FALSE(parser.parse(tokens("ac")).accepted);
+    EXPECT_FALSE(parser.parse(tokens("acc")).accepted);
+
+    ParseResults results = parser.parse(tokens("acda"));
+    EXPECT_FALSE(results.accepted);
+    EXPECT_EQ(3u, results.errorIndex);
+
+    // Only the state reached through c is split
+    EXPECT_EQ(lalr.numStates() + 1, parser.numStates());
+}
+
+TEST_F(TestParsers, LR1MergesCompatibleStates) {
+    cfg << "<E> ::= <E>+<T>|<T>";
+    cfg << "<T> ::= <T>*<F>|<F>";
+    cfg << "<F> ::= (<E>)|i";
+    parser::SLR1 slr(cfg);
+    parser::LR1 parser(cfg);
+    ASSERT_TRUE(parser.canParse());
+    // Canonical LR(1) has 22 states here, Pager's merging has the LR(0) ones
+    EXPECT_EQ(12u, slr.numStates());
+    EXPECT_EQ(12u, parser.numStates());
+    EXPECT_TRUE(parser.parse(tokens("i+i*(i+i)")).accepted);
+    EXPECT_FALSE(parser.parse(tokens("i+*i")).accepted);
+
+    // A merged state that gains lookaheads must be expanded again
+    cfg.clear();
+    cfg << "<S> ::= a<X>a|b<X>b|a<Y>b|b<Y>a";
+    cfg << "<X> ::= <Z>";
+    cfg << "<Y> ::= <Z>c";
+    cfg << "<Z> ::= d<Z>|d";
+    parser::LR1 nested(cfg);
+    ASSERT_TRUE(nested.canParse());
+    EXPECT_TRUE(nested.parse(tokens("adda")).accepted);
+    EXPECT_TRUE(nested.parse(tokens("bdb")).accepted);
+    EXPECT_TRUE(nested.parse(tokens("addcb")).accepted);
+    EXPECT_TRUE(nested.parse(tokens("bdca")).accepted);
+    EXPECT_FALSE(nested.parse(tokens("addb")).accepted);
+    EXPECT_FALSE(nested.parse(tokens("bdcb")).accepted);
+}
+
+TEST_F(TestParsers, GLRForest) {
+    cfg << "<E> ::= <E>+<E>|<E>*<E>|n";
+    parser::GLR parser(cfg);
+    ASSERT_TRUE(parser.canParse());
+    EXPECT_FALSE(parser::LALR1(cfg).canParse());
+
+    ASSERT_TRUE(parser.parse(tokens("n")).accepted);
+    EXPECT_EQ(1u, countTrees(parser));
+    ASSERT_TRUE(parser.parse(tokens("n+n*n")).accepted);
+    EXPECT_EQ(2u, countTrees(parser));
+    ASSERT_TRUE(parser.parse(tokens("n+n*n+n")).accepted);
+    EXPECT_EQ(5u, countTrees(parser));
+    ASSERT_TRUE(parser.parse(tokens("n+n+n*n+n*n")).accepted);
+    EXPECT_EQ(42u, countTrees(parser));
+
+    const auto& root = parser.forest()[parser.root()];
+    EXPECT_EQ(cfg.id("<E>"), root.symbol);
+    EXPECT_EQ(0u, root.start);
+    EXPECT_EQ(11u, root.end);
+
+    ParseResults results = parser.parse(tokens("n+*n"));
+    EXPECT_FALSE(results.accepted);
+    EXPECT_EQ(2u, results.errorIndex);
+    EXPECT_FALSE(parser.parse(tokens("n+")).accepted);
+    EXPECT_FALSE(parser.parse(tokens("")).accepted);
+}
+
+TEST_F(TestParsers, GLRTerminalIds) {
+    cfg << "<E> ::= <E>+<E>|<E>*<E>|n";
+    parser::GLR parser(cfg);
+    auto n = cfg.id("n");
+    auto plus = cfg.id("+");
+    auto times = cfg.id("*");
+    std::vector<CFG::SymbolId> ids = {n, plus, n, times, n};
+    ASSERT_TRUE(parser.parse(ids).accepted);
+    EXPECT_EQ(2u, countTrees(parser));
+
+    ids = {n, plus, cfg.id("<E>")};
+    EXPECT_EQ(2u, parser.parse(ids).errorIndex);
+    ids = {n, plus};
+    ParseResults results = parser.parse(ids);
+    EXPECT_EQ(2u, results.errorIndex);
+    EXPECT_NE(std::string::npos, results.errorMessage.find("Unexpected token 'EOS'"));
+
+    // Errors at the end of the input name the actual end marker
+    auto didactic = CFG::create(DidacticNotation());
+    didactic << "EOS -> EOS + EOS | n";
+    parser::GLR renamed(didactic);
+    results = renamed.parse(tokens("n+"));
+    EXPECT_EQ(2u, results.errorIndex);
+    EXPECT_NE(std::string::npos, results.errorMessage.find("Unexpected token 'EOS''"));
+}
+
+TEST_F(TestParsers, GLRNullable) {
+    cfg << "<S> ::= <A><S>|";
+    cfg << "<A> ::= a";
+    parser::GLR parser(cfg);
+    EXPECT_TRUE(parser.parse(tokens("")).accepted);
+    EXPECT_TRUE(parser.parse(tokens("a")).accepted);
+    EXPECT_TRUE(parser.parse(tokens("aaaa")).accepted);
+    EXPECT_FALSE(parser.parse(tokens("ab")).accepted);
+
+    // Hidden right recursion: <S> is followed by a nullable symbol
+    cfg.clear();
+    cfg << "<S> ::= a<S><B>|a";
+    cfg << "<B> ::= b|";
+    parser::GLR hidden(cfg);
+    EXPECT_TRUE(hidden.parse(tokens("a")).accepted);
+    EXPECT_TRUE(hidden.parse(tokens("aaa")).accepted);
+    EXPECT_TRUE(hidden.parse(tokens("aab")).accepted);
+    EXPECT_TRUE(hidden.parse(tokens("aaabb")).accepted);
+    EXPECT_FALSE(hidden.parse(tokens("ab")).accepted);
+    EXPECT_FALSE(hidden.parse(tokens("aabb")).accepted);
+    EXPECT_FALSE(hidden.parse(tokens("")).accepted);
+
+    // Ambiguous, with empty derivations in the middle
+    cfg.clear();
+    cfg << "<S> ::= <S><A><S>|b";
+    cfg << "<A> ::= a|";
+    parser::GLR ambiguous(cfg);
+    ASSERT_TRUE(ambiguous.parse(tokens("bab")).accepted);
+    EXPECT_EQ(1u, countTrees(ambiguous));
+    ASSERT_TRUE(ambiguous.parse(tokens("bbb")).accepted);
+    EXPECT_EQ(2u, countTrees(ambiguous));
+    EXPECT_FALSE(ambiguous.parse(tokens("ba")).accepted);
+}
+
+TEST_F(TestParsers, GLRLinearWork) {
+    cfg << "<S> ::= a<S>|a";
+    parser::GLR rightRecursive(cfg);
+    expectLinear(rightRecursive, &parser::GLR::numSteps, "a");
+
+    cfg.clear();
+    cfg << "<S> ::= <A><S>|";
+    cfg << "<A> ::= a";
+    parser::GLR nullable(cfg);
+    expectLinear(nullable, &parser::GLR::numSteps, "aa");
+
+    cfg.clear();
+    cfg << "<E> ::= <T>+<E>|<T>";
+    cfg << "<T> ::= i";
+    parser::GLR expression(cfg);
+    expectLinear(expression, &parser::GLR::numSteps, "i+");
+}
+
+TEST_F(TestParsers, EarleyAmbiguous) {
+    cfg << "<E> ::= <E>+<E>|<E>*<E>|n";
+    parser::Earley parser(cfg);
+    ASSERT_TRUE(parser.canParse());
+    EXPECT_TRUE(parser.parse(tokens("n")).accepted);
+    EXPECT_TRUE(parser.parse(tokens("n+n*n")).accepted);
+    EXPECT_TRUE(parser.parse(tokens("n+n+n*n+n*n")).accepted);
+
+    ParseResults results = parser.parse(tokens("n+*n"));
+    EXPECT_FALSE(results.accepted);
+    EXPECT_EQ(2u, results.errorIndex);
+    results = parser.parse(tokens("n+"));
+    EXPECT_FALSE(results.accepted);
+    EXPECT_EQ(2u, results.errorIndex);
+    results = parser.parse(tokens("nn"));
+    EXPECT_FALSE(results.accepted);
+    EXPECT_EQ(1u, results.errorIndex);
+}
+
+TEST_F(TestParsers, EarleyCyclic) {
+    cfg << "<S> ::= <X>|<S><S>|a";
+    cfg << "<X> ::= <Y>";
+    cfg << "<Y> ::= <X>|b";
+    parser::Earley parser(cfg);
+    EXPECT_TRUE(parser.parse(tokens("a")).accepted);
+    EXPECT_TRUE(parser.parse(tokens("b")).accepted);
+    EXPECT_TRUE(parser.parse(tokens("abba")).accepted);
+
+    ParseResults results = parser.parse(tokens("abc"));
+    EXPECT_FALSE(results.accepted);
+    EXPECT_EQ(2u, results.errorIndex);
+    EXPECT_FALSE(parser.parse(tokens("")).accepted);
+}
+
+TEST_F(TestParsers, EarleyNullable) {
+    cfg << "<S> ::= <A><B><A>c";
+    cfg << "<A> ::= a|";
+    cfg << "<B> ::= <A><A>|b";
+    parser::Earley parser(cfg);
+    EXPECT_TRUE(parser.parse(tokens("c")).accepted);
+    EXPECT_TRUE(parser.parse(tokens("ac")).accepted);
+    EXPECT_TRUE(parser.parse(tokens("bc")).accepted);
+    EXPECT_TRUE(parser.parse(tokens("abac")).accepted);
+    EXPECT_TRUE(parser.parse(tokens("aaaac")).accepted);
+
+    ParseResults results = parser.parse(tokens("aaaaac"));
+    EXPECT_FALSE(results.accepted);
+    EXPECT_EQ(4u, results.errorIndex);
+    results = parser.parse(tokens("aabac"));
+    EXPECT_FALSE(results.accepted);
+    EXPECT_EQ(2u, results.errorIndex);
+    results = parser.parse(tokens("a"));
+    EXPECT_FALSE(results.accepted);
+    EXPECT_EQ(1u, results.errorIndex);
+}
+
+TEST_F(TestParsers, EarleyEmptyInput) {
+    cfg << "<S> ::= <A><S>|";
+    cfg << "<A> ::= a|";
+    parser::Earley nullable(cfg);
+    EXPECT_TRUE(nullable.parse(tokens("")).accepted);
+    EXPECT_TRUE(nullable.parse(tokens("aaa")).accepted);
+
+    cfg.clear();
+    cfg << "<S> ::= a<S>|a";
+    parser::Earley nonNullable(cfg);
+    ParseResults results = nonNullable.parse(tokens(""));
+    EXPECT_FALSE(results.accepted);
+    EXPECT_EQ(0u, results.errorIndex);
+}
+
+TEST_F(TestParsers, EarleyTerminalIds) {
+    cfg << "<E> ::= <E>+<E>|<E>*<E>|n";
+    parser::Earley parser(cfg);
+    auto n = cfg.id("n");
+    auto plus = cfg.id("+");
+    std::vector<CFG::SymbolId> ids = {n, plus, n, cfg.id("*"), n};
+    EXPECT_TRUE(parser.parse(ids).accepted);
+
+    ids = {n, plus, cfg.id("<E>")};
+    EXPECT_EQ(2u, parser.parse(ids).errorIndex);
+    ids = {n, CFG::npos};
+    EXPECT_EQ(1u, parser.parse(ids).errorIndex);
+
+    // Errors at the end of the input use a name that the CFG doesn't
+    ids = {n, plus};
+    ParseResults results = parser.parse(ids);
+    EXPECT_EQ(2u, results.errorIndex);
+    EXPECT_NE(std::string::npos, results.errorMessage.find("Unexpected token 'EOS'"));
+
+    auto didactic = CFG::create(DidacticNotation());
+    didactic << "EOS -> EOS + EOS | n";
+    parser::Earley renamed(didactic);
+    results = renamed.parse(tokens("n+"));
+    EXPECT_EQ(2u, results.errorIndex);
+    EXPECT_NE(std::string::npos, results.errorMessage.find("Unexpected token 'EOS''"));
+}
+
+TEST_F(TestParsers, EarleyLinearWork) {
+    // Right recursion is only linear through Leo items
+    cfg << "<S> ::= a<S>|a";
+    parser::Earley rightRecursive(cfg);
+    expectLinear(rightRecursive, &parser::Earley::numItems, "a");
+
+    cfg.clear();
+    cfg << "<E> ::= <T>+<E>|<T>";
+    cfg << "<T> ::= i";
+    parser::Earley expression(cfg);
+    expectLinear(expression, &parser::Earley::numItems, "i+");
+
+    cfg.clear();
+    cfg << "<S> ::= <S>a|a";
+    parser::Earley leftRecursive(cfg);
+    expectLinear(leftRecursive, &parser::Earley::numItems, "a");
+}
+
+TEST_F(TestParsers, LL1Tree) {
+    cfg << "<E> ::= <T><E1>";
+    cfg << "<E1> ::= +<T><E1>|";
+    cfg << "<T> ::= <F><T1>";
+    cfg << "<T1> ::= *<F><T1>|";
+    cfg << "<F> ::= (<E>)|i";
+    parser::LL1 parser(cfg);
+    ParseTree tree;
+    ASSERT_TRUE(parser.parse(tokens("i+i"), tree).accepted);
+    ASSERT_NE(nullptr, tree.root());
+    EXPECT_EQ("<E>0@0(<T>3@0(<F>7@0(i@0) <T1>5@1()) "
+        "<E1>1@1(+@1 <T>3@2(<F>7@2(i@2) <T1>5@3()) <E1>2@3()))", render(tree.root()));
+
+    ASSERT_TRUE(parser.parse(tokens("(i)"), tree).accepted);
+    EXPECT_EQ("<E>0@0(<T>3@0(<F>6@0((@0 <E>0@1(<T>3@1(<F>7@1(i@1) <T1>5@2()) <E1>2@2()) )@2) "
+        "<T1>5@3()) <E1>2@3())", render(tree.root()));
+
+    EXPECT_FALSE(parser.parse(tokens("i+"), tree).accepted);
+    EXPECT_EQ(nullptr, tree.root());
+    EXPECT_FALSE(parser.parse(tokens(""), tree).accepted);
+    EXPECT_EQ(nullptr, tree.root());
+}
+
+TEST_F(TestParsers, SLR1Tree) {
+    cfg << "<E> ::= <E>+<T>|<T>";
+    cfg << "<T> ::= <T>*<F>|<F>";
+    cfg << "<F> ::= (<E>)|i";
+    parser::SLR1 parser(cfg);
+    ParseTree tree;
+    ASSERT_TRUE(parser.parse(tokens("i+i*i"), tree).accepted);
+    ASSERT_NE(nullptr, tree.root());
+    EXPECT_EQ("<E>0@0(<E>1@0(<T>3@0(<F>5@0(i@0))) +@1 "
+        "<T>2@2(<T>3@2(<F>5@2(i@2)) *@3 <F>5@4(i@4)))", render(tree.root()));
+
+    EXPECT_FALSE(parser.parse(tokens("i+*i"), tree).accepted);
+    EXPECT_EQ(nullptr, tree.root());
+
+    // Empty nodes start at the following token
+    cfg.clear();
+    cfg << "<S> ::= <A>b<A>";
+    cfg << "<A> ::= a|";
+    parser::SLR1 empty(cfg);
+    ASSERT_TRUE(empty.parse(tokens("b"), tree).accepted);
+    EXPECT_EQ("<S>0@0(<A>2@0() b@0 <A>2@1())", render(tree.root()));
+    ASSERT_TRUE(empty.parse(tokens("ab"), tree).accepted);
+    EXPECT_EQ("<S>0@0(<A>1@0(a@0) b@1 <A>2@2())", render(tree.root()));
+}
+
+TEST_F(TestParsers, ParseTreeReuse) {
+    cfg << "<E> ::= <E>+<T>|<T>";
+    cfg << "<T> ::= <T>*<F>|<F>";
+    cfg << "<F> ::= (<E>)|i";
+    parser::SLR1 parser(cfg);
+    std::string sentence = "i";
+    for (std::size_t i = 0; i < 5000; i++) {
+        sentence += "+(i*i)";
+    }
+    std::vector<Token> input = tokens(sentence);
+
+    // The nodes of a parse are allocated where the previous ones were,
+    // even if they span several blocks
+    ParseTree tree;
+    ASSERT_TRUE(parser.parse(input, tree).accepted);
+    const ParseNode* root = tree.root();
+    std::string expected = render(root);
+    ASSERT_TRUE(parser.parse(tokens("i*i"), tree).accepted);
+    EXPECT_EQ("<E>1@0(<T>2@0(<T>3@0(<F>5@0(i@0)) *@1 <F>5@2(i@2)))", render(tree.root()));
+    ASSERT_TRUE(parser.parse(input, tree).accepted);
+    EXPECT_EQ(root, tree.root());
+    EXPECT_EQ(expected, render(tree.root()));
+
+    EXPECT_FALSE(parser.parse(tokens("i+"), tree).accepted);
+    EXPECT_EQ(nullptr, tree.root());
+    ASSERT_TRUE(parser.parse(input, tree).accepted);
+    EXPECT_EQ(root, tree.root());
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -166,6 +166,22 @@ TEST_F(TestRegex, CharClasses) {
     ASSERT_FALSE(regex.matches(""));
 }
 
+TEST_F(TestRegex, CharClassEdgeCases) {
+    Regex regex("[-a]+");
+    ASSERT_TRUE(regex.matches("a-a"));
+    ASSERT_FALSE(regex.matches("b"));
+
+    regex = Regex("[^a-c\xff]");
+    ASSERT_TRUE(regex.matches("d"));
+    ASSERT_TRUE(regex.matches("\xfe"));
+    ASSERT_FALSE(regex.matches("b"));
+    ASSERT_FALSE(regex.matches("\xff"));
+
+    regex = Regex("[\x80-\xff]+");
+    ASSERT_TRUE(regex.matches("\x80\xc3\xff"));
+    ASSERT_FALSE(regex.matches("a"));
+}
+
 TEST_F(TestRegex, EscapeSequences) {
     Regex regex("\\(.*\\)");
     ASSERT_TRUE(regex.matches("()"));
@@ -244,6 +260,138 @@ TEST_F(TestRegex, FinalTest) {
     ASSERT_FALSE(regex.matches("(01.01.2016)"));
 }
 
+TEST_F(TestRegex, DFAMode) {
+    std::vector<std::string> expressions = {
+        "ab+c|ac*b",
+        "(ba|a(ba)*a)*(ab)*",
+        "0?(10)*1?",
+        ".*@.+@",
+        "[A-Za-z_][A-Za-z0-9_]* = [0-9]+",
+        "[^0-9]+",
+        "[0-9]+\\.?[0-9]*|\\.[0-9]+",
+        ".{3,8}",
+        "a{2,}"
+    };
+    std::vector<std::string> inputs = {
+        "", "ab", "abbbbc", "accccccb", "abbccb", "bababaabababaaba",
+        "ababa", "01010101010", "0110101010", "@a@", "abc@xyz@", "@@",
+        "_a10 = 2", "3ab = 9", "z", "10239023", "3.1415926", ".3",
+        "123.456.789", "pimpl", "123456789", "aaaaaaa", "a"
+    };
+
+    for (auto& expr : expressions) {
+        Regex nfa(expr);
+        Regex dfa(expr, Regex::Mode::DFA);
+        for (auto& input : inputs) {
+            EXPECT_EQ(nfa.matches(input), dfa.matches(input)) << expr << " / " << input;
+        }
+    }
+
+    Regex regex("ab+c?", Regex::Mode::DFA);
+    regex.read('a');
+    ASSERT_FALSE(regex.matches());
+    ASSERT_FALSE(regex.aborted());
+    regex.read('b');
+    ASSERT_TRUE(regex.matches());
+    regex.read('c');
+    ASSERT_TRUE(regex.matches());
+    regex.read('c');
+    ASSERT_FALSE(regex.matches());
+    ASSERT_TRUE(regex.aborted());
+    regex.reset();
+    ASSERT_FALSE(regex.aborted());
+}
+
+TEST_F(TestRegex, LazyMode) {
+    Regex regex("ab+c|ac*b", Regex::Mode::LAZY);
+    ASSERT_TRUE(regex.matches("abbbbc"));
+    ASSERT_TRUE(regex.matches("accccccb"));
+    ASSERT_TRUE(regex.matches("ab"));
+    ASSERT_FALSE(regex.matches("abbccb"));
+    ASSERT_FALSE(regex.matches(""));
+
+    // The full DFA of this pattern has 2^13 states
+    std::string expr = "(a|b)*a(a|b){12}";
+    Regex nfa(expr);
+    Regex lazy(expr, Regex::Mode::LAZY);
+    Regex bounded(expr, Regex::Mode::LAZY);
+    bounded.setCacheLimit(16);
+
+    unsigned seed = 7;
+    for (unsigned i = 0; i < 200; i++) {
+        std::string input;
+        for (unsigned j = 0; j < 13 + i % 20; j++) {
+            seed = seed * 1103515245 + 12345;
+            input += ((seed >> 16) & 1) ? 'a' : 'b';
+        }
+        bool expected = nfa.matches(input);
+        EXPECT_EQ(expected, lazy.matches(input)) << input;
+        EXPECT_EQ(expected, bounded.matches(input)) << input;
+    }
+
+    bounded.reset();
+    bounded.read('a');
+    for (unsigned i = 0; i < 12; i++) {
+        ASSERT_FALSE(bounded.matches());
+        bounded.read('b');
+    }
+    ASSERT_TRUE(bounded.matches());
+    bounded.read('c');
+    ASSERT_TRUE(bounded.aborted());
+}
+
+TEST_F(TestRegex, LargeNFA) {
+    // Spans several words of the NFA state vectors, while its
+    // DFA would have 2^81 states
+    Regex regex("(a|b)*a(a|b){80}");
+    std::string input = "ba" + std::string(80, 'b');
+    ASSERT_TRUE(regex.matches(input));
+    ASSERT_FALSE(regex.matches(input + "b"));
+    ASSERT_TRUE(regex.matches(input + std::string(81, 'a')));
+    ASSERT_FALSE(regex.matches(std::string(200, 'b')));
+
+    regex.reset();
+    for (char c : input) {
+        ASSERT_FALSE(regex.aborted());
+        regex.read(c);
+    }
+    ASSERT_TRUE(regex.matches());
+    regex.read('c');
+    ASSERT_TRUE(regex.aborted());
+    ASSERT_FALSE(regex.matches());
+}
+
+TEST_F(TestRegex, ToDFA) {
+    Regex regex("(a|b)*abb");
+    DFA dfa = regex.toDFA();
+    dfa.read("babaabb");
+    EXPECT_TRUE(dfa.accepts());
+    EXPECT_FALSE(dfa.run("abba"));
+
+    DFA minimized = dfa.minimized();
+    EXPECT_EQ(4, minimized.size());
+    EXPECT_TRUE(minimized.run("abb"));
+    EXPECT_TRUE(minimized.run("aaabb"));
+    EXPECT_FALSE(minimized.run("ab"));
+}
+
+TEST_F(TestRegex, Combine) {
+    Regex keyword("while");
+    Regex identifier("[a-z]+");
+    Regex number("[0-9]+");
+    auto table = Regex::combine({&keyword, &identifier, &number});
+
+    EXPECT_EQ(0, table.tag(table.run("while")));
+    EXPECT_EQ(1, table.tag(table.run("whil")));
+    EXPECT_EQ(1, table.tag(table.run("whiles")));
+    EXPECT_EQ(2, table.tag(table.run("42")));
+    EXPECT_EQ(TransitionTable::untagged, table.tag(table.run("")));
+    EXPECT_EQ(TransitionTable::dead, table.run("4a"));
+
+    table = Regex::combine({&identifier, &keyword});
+    EXPECT_EQ(0, table.tag(table.run("while")));
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();